@@ -6,7 +6,7 @@ import re
 
 from esphome import automation
 import esphome.codegen as cg
-from esphome.components import text_sensor
+from esphome.components import output, text_sensor
 from esphome.components.esp32 import (
     CONF_PARTITIONS,
     add_extra_script,
@@ -22,20 +22,36 @@ from esphome.components.esp32.const import (
 )
 import esphome.config_validation as cv
 from esphome.const import (
+    CONF_ADDRESS,
     CONF_AP,
     CONF_AREA,
+    CONF_BUFFER_SIZE,
     CONF_COMPONENTS,
+    CONF_COUNT,
+    CONF_DATA,
     CONF_DATE,
     CONF_DEBUG,
     CONF_DEVICE,
+    CONF_DURATION,
+    CONF_EVENT,
     CONF_ID,
     CONF_LAMBDA,
+    CONF_LENGTH,
     CONF_MAX_LENGTH,
+    CONF_MODE,
     CONF_NAME,
     CONF_ON_VALUE,
+    CONF_OTA,
     CONF_POWER_SUPPLY,
+    CONF_PRIORITY,
+    CONF_RAW_DATA_ID,
+    CONF_RESTORE_VALUE,
+    CONF_SIZE,
+    CONF_SPEED,
+    CONF_TRANSITION_LENGTH,
     CONF_TRIGGER_ID,
     CONF_TYPE,
+    CONF_UPDATE_INTERVAL,
     CONF_VALUE,
     CONF_VERSION,
     CONF_WIFI,
@@ -47,34 +63,107 @@ import esphome.final_validate as fv
 from .const import (
     CONF_ACCESS,
     CONF_AS_GENERIC,
+    CONF_ATTRIBUTE,
     CONF_ATTRIBUTE_ID,
+    CONF_ATTRIBUTE_STATS,
     CONF_ATTRIBUTES,
+    CONF_BLOCK_SIZE,
+    CONF_CLEAR,
+    CONF_CLUSTER,
     CONF_CLUSTERS,
+    CONF_COEXISTENCE,
+    CONF_COLOR_X,
+    CONF_COLOR_Y,
+    CONF_COMMAND,
+    CONF_COMMAND_TIMEOUT,
+    CONF_CONSUMER_COSTS,
+    CONF_DESTINATION_ENDPOINT,
     CONF_DEVICE_TYPE,
     CONF_DEVICE_VERSION,
+    CONF_DIAGNOSTICS,
+    CONF_ENDPOINT,
     CONF_ENDPOINTS,
+    CONF_ENERGY_SCAN,
+    CONF_EVENTS,
+    CONF_FAST_OUTPUT,
+    CONF_FILE_VERSION,
+    CONF_GROUP,
+    CONF_GROUP_ID,
+    CONF_GROUPS,
+    CONF_IEEE_ADDRESS,
+    CONF_IMAGE_TYPE,
+    CONF_IO_BUFFER_SIZE,
     CONF_KEEP_ALIVE,
+    CONF_LEVEL,
     CONF_MANUFACTURER,
+    CONF_MANUFACTURER_CODE,
+    CONF_MAX_CHILDREN,
+    CONF_MIRROR,
+    CONF_NETWORK_SIZE,
     CONF_NUM,
+    CONF_ON_BOOT,
+    CONF_ON_COMMAND,
+    CONF_ON_ENERGY_SCAN,
     CONF_ON_JOIN,
     CONF_ON_REPORT,
+    CONF_ON_RESPONSE,
+    CONF_PAYLOADS,
+    CONF_PERIOD,
+    CONF_PERSIST_INTERVAL,
+    CONF_POLICY,
+    CONF_PREFERRED_CHANNELS,
+    CONF_QUERY_INTERVAL,
+    CONF_RATE,
+    CONF_RATES,
     CONF_REPORT,
     CONF_ROLE,
     CONF_ROUTER,
     CONF_SCALE,
+    CONF_SCENE,
+    CONF_SCENES,
+    CONF_SCHEDULER_QUEUE_SIZE,
     CONF_SLEEPY,
+    CONF_SOURCE,
+    CONF_STACK_SIZE,
+    CONF_STEP_SIZE,
+    CONF_TASK,
+    CONF_TRACE,
     CONF_TRUST_CENTER_KEY,
+    CONF_TTL,
+    CONF_WINDOW,
     BinarySensor,
     Sensor,
     Switch,
 )
 from .types import (
+    AttributeStatsAction,
+    BenchmarkAction,
+    CoexPolicy,
+    EnergyScanAction,
+    GroupAction,
+    InjectEventsAction,
+    LevelMoveCommandAction,
+    LevelStepCommandAction,
+    MoveToColorCommandAction,
+    MoveToLevelCommandAction,
+    OnOffCommandAction,
+    ReadAttrAction,
+    RecallSceneCommandAction,
     ReportAction,
     ReportAttrAction,
     ResetZigbeeAction,
     SetAttrAction,
+    TraceDumpAction,
+    TraceReplayAction,
+    WriteAttrAction,
+    ZBCommand,
+    ZBInjectConfig,
+    ZBInjectEvent,
+    ZBRxInfo,
     ZigBeeAttribute,
+    ZigBeeAttrResponseTrigger,
     ZigBeeComponent,
+    ZigBeeOnCommandTrigger,
     ZigBeeOnReportTrigger,
     ZigBeeOnValueTrigger,
 )
@@ -114,8 +203,22 @@ def _register_action(name, action_type, schema, **kwargs):
 
 DEPENDENCIES = ["esp32"]
 
+COEX_POLICIES = {
+    "balanced": CoexPolicy.COEX_POLICY_BALANCED,
+    "zigbee": CoexPolicy.COEX_POLICY_ZIGBEE,
+    "zigbee_window": CoexPolicy.COEX_POLICY_ZIGBEE_WINDOW,
+    "wifi": CoexPolicy.COEX_POLICY_WIFI,
+}
+
+INJECT_EVENTS = {
+    "set_attr": ZBInjectEvent.INJECT_SET_ATTR,
+    "report_attr": ZBInjectEvent.INJECT_REPORT_ATTR,
+    "read_resp": ZBInjectEvent.INJECT_READ_RESP,
+}
+
 _CALLBACK_AUTOMATIONS = (
     automation.CallbackAutomation(CONF_ON_JOIN, "add_on_join_callback"),
+    automation.CallbackAutomation(CONF_ON_ENERGY_SCAN, "add_on_energy_scan_callback"),
 )
 
 comp_ids = 0
@@ -163,15 +266,39 @@ def get_c_size(bits, options):
     return str([n for n in options if n >= int(bits)][0])
 
 
+# Fixed size types without the size in their name
+ID_TYPES = {
+    "TIME_OF_DAY": cg.uint32,
+    "DATE": cg.uint32,
+    "UTC_TIME": cg.uint32,
+    "CLUSTER_ID": cg.uint16,
+    "ATTRIBUTE_ID": cg.uint16,
+    "BACNET_OID": cg.uint32,
+    "IEEE_ADDR": cg.uint64,
+}
+# Length prefixed types, passed as std::string of the raw content
+BYTES_TYPES = (
+    "OCTET_STRING",
+    "CHAR_STRING",
+    "LONG_OCTET_STRING",
+    "LONG_CHAR_STRING",
+    "ARRAY",
+    "16BIT_ARRAY",
+    "32BIT_ARRAY",
+)
+
+
 def get_c_type(attr_type):
     if attr_type == "BOOL":
         return cg.bool_
-    if attr_type == "SINGLE":
+    if attr_type in ["SEMI", "SINGLE"]:
         return cg.float_
     if attr_type == "DOUBLE":
         return cg.double
-    if "STRING" in attr_type:
+    if attr_type in BYTES_TYPES:
         return cg.std_string
+    if attr_type in ID_TYPES:
+        return ID_TYPES[attr_type]
     test = re.match(r"(^U?)(\d{1,2})(BITMAP$|BIT$|BIT_ENUM$|$)", attr_type)
     if test and test.group(2):
         return getattr(cg, "uint" + get_c_size(test.group(2), [8, 16, 32, 64]))
@@ -186,8 +313,10 @@ def get_cv_by_type(attr_type):
         return cv.boolean
     if attr_type in ["SEMI", "SINGLE", "DOUBLE"]:
         return cv.float_
-    if "STRING" in attr_type:
+    if attr_type in BYTES_TYPES:
         return cv.string
+    if attr_type in ID_TYPES:
+        return cv.positive_int
     test = re.match(r"(^U?)(\d{1,2})(BITMAP$|BIT$|BIT_ENUM$|$)", attr_type)
     if test and test.group(2):
         return cv.positive_int
@@ -198,7 +327,7 @@ def get_cv_by_type(attr_type):
 
 
 def get_default_by_type(attr_type):
-    if "CHAR_STRING" == attr_type:
+    if attr_type in BYTES_TYPES:
         return ""
     return 0
 
@@ -214,13 +343,21 @@ def validate_clusters(config):
 
 
 def validate_string_attributes(config):
-    if "CHAR_STRING" == config[CONF_TYPE]:
+    if config[CONF_TYPE] in BYTES_TYPES:
         if CONF_MAX_LENGTH not in config.keys():
             raise cv.Invalid(
                 f"The '{CONF_MAX_LENGTH}' parameter is mandatory for string attributes."
             )
         if config[CONF_MAX_LENGTH] == 0:
             config[CONF_MAX_LENGTH] = len(config.get(CONF_VALUE, ""))
+        # short strings have a 1 byte length, 0xFF marks an invalid value
+        if (
+            config[CONF_TYPE] in ("OCTET_STRING", "CHAR_STRING")
+            and config[CONF_MAX_LENGTH] > 254
+        ):
+            raise cv.Invalid(
+                f"The '{CONF_MAX_LENGTH}' of {config[CONF_TYPE]} attributes is at most 254, use LONG_{config[CONF_TYPE]}."
+            )
         # Check that size of default value matches CONF_MAX_LENGTH
         if len(config[CONF_VALUE]) > config[CONF_MAX_LENGTH]:
             raise cv.Invalid(
@@ -229,6 +366,29 @@ def validate_string_attributes(config):
     return config
 
 
+VARIABLE_SIZE_TYPES = (
+    "OCTET_STRING",
+    "CHAR_STRING",
+    "LONG_OCTET_STRING",
+    "LONG_CHAR_STRING",
+    "ARRAY",
+    "16BIT_ARRAY",
+    "32BIT_ARRAY",
+    "STRUCTURE",
+    "SET",
+    "BAG",
+)
+
+
+def is_scalar_type(attr_type):
+    # fixed size of 1 to 8 bytes, as stored by restore_value and scenes
+    return attr_type not in VARIABLE_SIZE_TYPES and attr_type not in (
+        "NULL",
+        "128_BIT_KEY",
+        "INVALID",
+    )
+
+
 def validate_attributes(config):
     if CONF_VALUE in config:
         config[CONF_VALUE] = get_cv_by_type(config[CONF_TYPE])(config[CONF_VALUE])
@@ -240,8 +400,19 @@ def validate_attributes(config):
         else 0
     )
     validate_string_attributes(config)
+    if CONF_FAST_OUTPUT in config and config[CONF_TYPE] in VARIABLE_SIZE_TYPES:
+        raise cv.Invalid(
+            f"'{CONF_FAST_OUTPUT}' is only supported for fixed size attribute types."
+        )
+    if config.get(CONF_RESTORE_VALUE) and not is_scalar_type(config[CONF_TYPE]):
+        raise cv.Invalid(
+            f"'{CONF_RESTORE_VALUE}' is only supported for fixed size attribute types up to 8 bytes."
+        )
     if (CONF_ID not in config) and (
-        CONF_DEVICE in config or CONF_ON_VALUE in config or CONF_ON_REPORT in config
+        CONF_DEVICE in config
+        or CONF_ON_VALUE in config
+        or CONF_ON_REPORT in config
+        or config.get(CONF_RESTORE_VALUE)
     ):
         config[CONF_ID] = cv.declare_id(ZigBeeAttribute)(None)
     elif all(
@@ -254,6 +425,55 @@ def validate_attributes(config):
     return config
 
 
+def validate_ieee_address(value):
+    value = cv.string_strict(value)
+    parts = value.split(":")
+    if len(parts) != 8 or not all(len(part) == 2 for part in parts):
+        raise cv.Invalid(
+            "IEEE address must be 8 hex bytes like 00:12:4B:00:01:02:03:04"
+        )
+    try:
+        return int("".join(parts), 16)
+    except ValueError as err:
+        raise cv.Invalid(f"Invalid IEEE address '{value}'") from err
+
+
+REPORT_SOURCE_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_ADDRESS): cv.ensure_list(cv.hex_uint16_t),
+        cv.Optional(CONF_IEEE_ADDRESS): cv.ensure_list(validate_ieee_address),
+        cv.Optional(CONF_ENDPOINT): cv.ensure_list(cv.int_range(1, 240)),
+    }
+)
+
+
+def validate_coexistence(config):
+    if config[CONF_WINDOW] >= config[CONF_PERIOD]:
+        raise cv.Invalid(f"'{CONF_WINDOW}' must be shorter than '{CONF_PERIOD}'.")
+    return config
+
+
+def validate_router_options(config):
+    if CONF_MAX_CHILDREN in config and not config[CONF_ROUTER]:
+        raise cv.Invalid(f"'{CONF_MAX_CHILDREN}' is only supported for routers.")
+    return config
+
+
+def validate_diagnostics(config):
+    if (diagnostics := config.get(CONF_DIAGNOSTICS)) is None:
+        return config
+    for ep in config.get(CONF_ENDPOINTS, []):
+        if ep.get(CONF_NUM) != diagnostics[CONF_ENDPOINT]:
+            continue
+        for cl in ep.get(CONF_CLUSTERS, []):
+            if cl[CONF_ID] == diagnostics[CONF_CLUSTER]:
+                raise cv.Invalid(
+                    f"Cluster 0x{cl[CONF_ID]:04X} of endpoint {ep[CONF_NUM]} is used by '{CONF_DIAGNOSTICS}', "
+                    f"set another '{CONF_CLUSTER}'."
+                )
+    return config
+
+
 def final_validate(config):
     esp_conf = fv.full_config.get()["esp32"]
     if CONF_PARTITIONS in esp_conf:
@@ -265,6 +485,8 @@ def final_validate(config):
                 raise cv.Invalid(
                     "Add \n'zb_storage, data, fat,   , 16K,'\n'zb_fct, data, fat, , 1K,'\n to your custom partition table."
                 )
+    if CONF_COEXISTENCE in config and CONF_WIFI not in fv.full_config.get():
+        raise cv.Invalid(f"'{CONF_COEXISTENCE}' requires the 'wifi' component.")
     if CONF_WIFI in fv.full_config.get():
         if config[CONF_ROUTER] and CONF_AP in fv.full_config.get()[CONF_WIFI]:
             raise cv.Invalid(
@@ -274,10 +496,13 @@ def final_validate(config):
             _LOGGER.warning(
                 "Wifi Access Point might be unstable while Zigbee is active, use only as fallback."
             )
-        elif config[CONF_ROUTER]:
+        elif config[CONF_ROUTER] and config.get(CONF_COEXISTENCE, {}).get(
+            CONF_POLICY, "balanced"
+        ) in ("balanced", "wifi"):
             _LOGGER.warning(
                 "The Zigbee Router might miss packets while Wifi is active and could destabilize "
-                "your network. Use only if Wifi is off most of the time."
+                "your network. Use only if Wifi is off most of the time or set a Zigbee "
+                "coexistence policy."
             )
     if config.get(CONF_SLEEPY):
         if config[CONF_ROUTER]:
@@ -324,6 +549,94 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_DEBUG, default=False): cv.boolean,
             cv.Optional(CONF_SLEEPY): cv.boolean,
             cv.Optional(CONF_KEEP_ALIVE, default=3000): cv.int_range(100, 65535),
+            cv.Optional(CONF_MAX_CHILDREN): cv.int_range(1, 255),
+            cv.Optional(CONF_NETWORK_SIZE): cv.int_range(16, 1024),
+            cv.Optional(CONF_IO_BUFFER_SIZE): cv.int_range(16, 1024),
+            cv.Optional(CONF_SCHEDULER_QUEUE_SIZE): cv.int_range(16, 256),
+            cv.Optional(CONF_COEXISTENCE): cv.All(
+                cv.Schema(
+                    {
+                        cv.Optional(CONF_POLICY, default="balanced"): cv.enum(
+                            COEX_POLICIES, lower=True
+                        ),
+                        cv.Optional(
+                            CONF_WINDOW, default="100ms"
+                        ): cv.positive_time_period_milliseconds,
+                        cv.Optional(
+                            CONF_PERIOD, default="1s"
+                        ): cv.positive_time_period_milliseconds,
+                    }
+                ),
+                validate_coexistence,
+            ),
+            cv.Optional(
+                CONF_COMMAND_TIMEOUT, default="3s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MIRROR, default={}): cv.Schema(
+                {
+                    cv.Optional(CONF_SIZE, default=16): cv.int_range(0, 64),
+                    cv.Optional(
+                        CONF_TTL, default="1h"
+                    ): cv.positive_time_period_milliseconds,
+                }
+            ),
+            cv.Optional(
+                CONF_PERSIST_INTERVAL, default="60s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_OTA): cv.Schema(
+                {
+                    cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+                    cv.Optional(
+                        CONF_MANUFACTURER_CODE, default=0x131B
+                    ): cv.hex_uint16_t,
+                    cv.Optional(CONF_IMAGE_TYPE, default=0): cv.hex_uint16_t,
+                    cv.Required(CONF_FILE_VERSION): cv.hex_uint32_t,
+                    cv.Optional(CONF_BLOCK_SIZE, default=64): cv.int_range(16, 223),
+                    cv.Optional(CONF_QUERY_INTERVAL, default="1440min"): cv.All(
+                        cv.positive_time_period_minutes,
+                        cv.Range(
+                            min=cv.TimePeriod(minutes=1),
+                            max=cv.TimePeriod(minutes=65535),
+                        ),
+                    ),
+                }
+            ),
+            cv.Optional(CONF_TASK, default={}): cv.Schema(
+                {
+                    cv.Optional(CONF_STACK_SIZE, default=4096): cv.int_range(
+                        2048, 16384
+                    ),
+                    cv.Optional(CONF_PRIORITY, default=24): cv.int_range(1, 24),
+                }
+            ),
+            cv.Optional(CONF_ATTRIBUTE_STATS, default=False): cv.boolean,
+            cv.Optional(CONF_DIAGNOSTICS): cv.Schema(
+                {
+                    cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+                    cv.Optional(
+                        CONF_UPDATE_INTERVAL, default="60s"
+                    ): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_CLUSTER, default=0xFC00): cv.int_range(
+                        0xFC00, 0xFFFF
+                    ),
+                }
+            ),
+            cv.Optional(CONF_TRACE): cv.Schema(
+                {
+                    cv.Optional(CONF_BUFFER_SIZE, default=4096): cv.int_range(
+                        256, 65535
+                    ),
+                }
+            ),
+            cv.Optional(CONF_ENERGY_SCAN): cv.Schema(
+                {
+                    cv.Optional(CONF_ON_BOOT, default=True): cv.boolean,
+                    cv.Optional(CONF_DURATION, default=3): cv.int_range(0, 14),
+                    cv.Optional(CONF_PREFERRED_CHANNELS, default=4): cv.int_range(
+                        1, 16
+                    ),
+                }
+            ),
             cv.Optional(CONF_COMPONENTS): cv.Any(
                 cv.one_of("all", "none", lower=True),
                 cv.ensure_list(cv.use_id(cg.EntityBase)),
@@ -334,6 +647,10 @@ CONFIG_SCHEMA = cv.All(
                     {
                         cv.Required(CONF_DEVICE_TYPE): cv.enum(DEVICE_ID, upper=True),
                         cv.Optional(CONF_NUM): cv.int_range(1, 240),
+                        cv.Optional(CONF_SCENES, default=False): cv.boolean,
+                        cv.Optional(CONF_GROUPS): cv.ensure_list(
+                            cv.All(cv.hex_uint16_t, cv.Range(min=0x0001, max=0xFFF7))
+                        ),
                         cv.Optional(CONF_CLUSTERS): cv.ensure_list(
                             cv.Schema(
                                 {
@@ -364,6 +681,9 @@ CONFIG_SCHEMA = cv.All(
                                                     cv.boolean,
                                                     cv.one_of("force", lower=True),
                                                 ),
+                                                cv.Optional(
+                                                    CONF_RESTORE_VALUE, default=False
+                                                ): cv.boolean,
                                                 cv.Optional(
                                                     CONF_ON_VALUE
                                                 ): automation.validate_automation(
@@ -378,6 +698,9 @@ CONFIG_SCHEMA = cv.All(
                                                 cv.Optional(CONF_DEVICE): cv.use_id(
                                                     cg.EntityBase
                                                 ),
+                                                cv.Optional(
+                                                    CONF_FAST_OUTPUT
+                                                ): cv.use_id(output.BinaryOutput),
                                                 cv.Optional(
                                                     CONF_SCALE, default=1.0
                                                 ): cv.float_,
@@ -386,17 +709,21 @@ CONFIG_SCHEMA = cv.All(
                                                 ): cv.returning_lambda,
                                                 cv.Optional(
                                                     CONF_MAX_LENGTH
-                                                ): cv.int_range(0, 254),
-                                                cv.Optional(
-                                                    CONF_ON_REPORT
-                                                ): automation.validate_automation(
-                                                    {
-                                                        cv.GenerateID(
-                                                            CONF_TRIGGER_ID
-                                                        ): cv.declare_id(
-                                                            ZigBeeOnReportTrigger
-                                                        ),
-                                                    }
+                                                ): cv.int_range(0, 0xFFFE),
+                                                cv.Optional(CONF_ON_REPORT): cv.All(
+                                                    automation.validate_automation(
+                                                        {
+                                                            cv.GenerateID(
+                                                                CONF_TRIGGER_ID
+                                                            ): cv.declare_id(
+                                                                ZigBeeOnReportTrigger
+                                                            ),
+                                                            cv.Optional(
+                                                                CONF_SOURCE
+                                                            ): REPORT_SOURCE_SCHEMA,
+                                                        }
+                                                    ),
+                                                    cv.Length(max=64),
                                                 ),
                                             }
                                         ),
@@ -410,8 +737,21 @@ CONFIG_SCHEMA = cv.All(
                 ),
             ),
             cv.Optional(CONF_ON_JOIN): automation.validate_automation({}),
+            cv.Optional(CONF_ON_ENERGY_SCAN): automation.validate_automation({}),
+            cv.Optional(CONF_ON_COMMAND): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(
+                        ZigBeeOnCommandTrigger
+                    ),
+                    cv.Required(CONF_ENDPOINT): cv.int_range(1, 240),
+                    cv.Required(CONF_CLUSTER): cv.int_range(0xFC00, 0xFFFF),
+                    cv.Required(CONF_COMMAND): cv.hex_uint8_t,
+                }
+            ),
         }
     ).extend(cv.COMPONENT_SCHEMA),
+    validate_router_options,
+    validate_diagnostics,
     cv.require_framework_version(esp_idf=cv.Version(5, 1, 2)),
     _require_vfs_select,
     only_on_variant(
@@ -435,6 +775,17 @@ def find_attr(conf, id):
 
 async def attributes_to_code(var, ep_num, cl):
     for attr in cl.get(CONF_ATTRIBUTES, []):
+        if CONF_FAST_OUTPUT in attr:
+            cg.add_define("USE_ZIGBEE_FAST_PATH")
+            out = await cg.get_variable(attr[CONF_FAST_OUTPUT])
+            cg.add(
+                var.add_fast_output(
+                    ep_num,
+                    CLUSTER_ID.get(cl[CONF_ID], cl[CONF_ID]),
+                    attr[CONF_ATTRIBUTE_ID],
+                    out,
+                )
+            )
         if attr.get(CONF_ID) is None:
             cg.add(
                 var.add_attr(
@@ -470,6 +821,8 @@ async def attributes_to_code(var, ep_num, cl):
         )
         if attr[CONF_REPORT]:
             cg.add(attr_var.set_report(attr[CONF_REPORT] == "force"))
+        if attr.get(CONF_RESTORE_VALUE, False):
+            cg.add(attr_var.set_restore())
 
         if CONF_LAMBDA in attr:
             lambda_ = await cg.process_lambda(
@@ -518,7 +871,7 @@ async def attributes_to_code(var, ep_num, cl):
             )
             await cg.register_component(trigger, conf)
             await automation.build_automation(
-                trigger, [(get_c_type(attr[CONF_TYPE]), "x")], conf
+                trigger, [(get_c_type(attr[CONF_TYPE]), "x"), (ZBRxInfo, "rx")], conf
             )
 
         for conf in attr.get(CONF_ON_REPORT, []):
@@ -528,6 +881,17 @@ async def attributes_to_code(var, ep_num, cl):
                 attr_var,
             )
             await cg.register_component(trigger, conf)
+            source = conf.get(CONF_SOURCE, {})
+            for address in source.get(CONF_ADDRESS, []):
+                cg.add(trigger.add_source_address(address))
+            for ieee_address in source.get(CONF_IEEE_ADDRESS, []):
+                cg.add(
+                    trigger.add_source_ieee_address(
+                        cg.RawExpression(f"0x{ieee_address:016X}ULL")
+                    )
+                )
+            for endpoint in source.get(CONF_ENDPOINT, []):
+                cg.add(trigger.add_source_endpoint(endpoint))
             value_type = get_c_type(attr[CONF_TYPE])
             automation_arg_type = "esphome::zigbee::ZigBeeReportData" + str(
                 cg.TemplateArguments(value_type)
@@ -598,6 +962,72 @@ async def to_code(config):
         cg.add(var.set_trust_center_key(config[CONF_TRUST_CENTER_KEY]))
     if CONF_DEVICE_VERSION in config:
         cg.add(var.set_device_version(config[CONF_DEVICE_VERSION]))
+    if CONF_MAX_CHILDREN in config:
+        cg.add(var.set_max_children(config[CONF_MAX_CHILDREN]))
+    if CONF_NETWORK_SIZE in config:
+        cg.add(var.set_network_size(config[CONF_NETWORK_SIZE]))
+    if CONF_IO_BUFFER_SIZE in config:
+        cg.add(var.set_io_buffer_size(config[CONF_IO_BUFFER_SIZE]))
+    if CONF_SCHEDULER_QUEUE_SIZE in config:
+        cg.add(var.set_scheduler_queue_size(config[CONF_SCHEDULER_QUEUE_SIZE]))
+    cg.add(var.set_command_timeout(config[CONF_COMMAND_TIMEOUT].total_milliseconds))
+    cg.add(var.set_persist_interval(config[CONF_PERSIST_INTERVAL].total_milliseconds))
+    if ota := config.get(CONF_OTA):
+        cg.add_define("USE_ZIGBEE_OTA")
+        # read by the post build script that creates the Zigbee OTA file
+        cg.add_define("ZB_OTA_MANUFACTURER_CODE", ota[CONF_MANUFACTURER_CODE])
+        cg.add_define("ZB_OTA_IMAGE_TYPE", ota[CONF_IMAGE_TYPE])
+        cg.add_define("ZB_OTA_FILE_VERSION", ota[CONF_FILE_VERSION])
+        add_extra_script(
+            "post",
+            "zigbee_ota_image.py",
+            Path(__file__).parent / "zigbee_ota_image.py.script",
+        )
+        cg.add(
+            var.set_ota(
+                ota[CONF_ENDPOINT],
+                ota[CONF_MANUFACTURER_CODE],
+                ota[CONF_IMAGE_TYPE],
+                ota[CONF_FILE_VERSION],
+                ota[CONF_BLOCK_SIZE],
+                ota[CONF_QUERY_INTERVAL].total_minutes,
+            )
+        )
+    task = config[CONF_TASK]
+    cg.add(var.set_task(task[CONF_STACK_SIZE], task[CONF_PRIORITY]))
+    if config[CONF_ATTRIBUTE_STATS]:
+        cg.add_define("USE_ZIGBEE_ATTR_STATS")
+    if diagnostics := config.get(CONF_DIAGNOSTICS):
+        cg.add_define("USE_ZIGBEE_DIAGNOSTICS")
+        cg.add(
+            var.set_diagnostics(
+                diagnostics[CONF_ENDPOINT],
+                diagnostics[CONF_UPDATE_INTERVAL].total_milliseconds,
+                diagnostics[CONF_CLUSTER],
+            )
+        )
+    if trace := config.get(CONF_TRACE):
+        cg.add_define("USE_ZIGBEE_INJECT")
+        cg.add_define("USE_ZIGBEE_TRACE")
+        cg.add(var.set_trace_size(trace[CONF_BUFFER_SIZE]))
+    mirror = config[CONF_MIRROR]
+    cg.add(var.set_mirror(mirror[CONF_SIZE], mirror[CONF_TTL].total_milliseconds))
+    if coex := config.get(CONF_COEXISTENCE):
+        cg.add(
+            var.set_coex_policy(
+                coex[CONF_POLICY],
+                coex[CONF_WINDOW].total_milliseconds,
+                coex[CONF_PERIOD].total_milliseconds,
+            )
+        )
+    if energy_scan := config.get(CONF_ENERGY_SCAN):
+        cg.add(
+            var.set_energy_scan(
+                energy_scan[CONF_ON_BOOT],
+                energy_scan[CONF_DURATION],
+                energy_scan[CONF_PREFERRED_CHANNELS],
+            )
+        )
 
     if CONF_NAME not in config:
         config[CONF_NAME] = CORE.name or ""
@@ -627,7 +1057,24 @@ async def to_code(config):
                 )
             )
             await attributes_to_code(var, ep[CONF_NUM], cl)
+        if ep.get(CONF_SCENES, False):
+            cg.add(var.add_scenes_cluster(ep[CONF_NUM]))
+        if CONF_GROUPS in ep:
+            cg.add(var.add_groups_cluster(ep[CONF_NUM]))
+            for group in ep[CONF_GROUPS]:
+                cg.add(var.add_group_membership(ep[CONF_NUM], group))
     await automation.build_callback_automations(var, config, _CALLBACK_AUTOMATIONS)
+    for conf in config.get(CONF_ON_COMMAND, []):
+        trigger = cg.new_Pvariable(
+            conf[CONF_TRIGGER_ID],
+            var,
+            conf[CONF_ENDPOINT],
+            conf[CONF_CLUSTER],
+            conf[CONF_COMMAND],
+        )
+        await automation.build_automation(
+            trigger, [(ZBCommand.operator("const").operator("ref"), "x")], conf
+        )
     await add_sdkconfigs(config)
 
 
@@ -662,6 +1109,274 @@ async def report_to_code(config, action_id, template_arg, args):
     return var
 
 
+@_register_action(
+    "zigbee.energy_scan",
+    EnergyScanAction,
+    automation.maybe_simple_id(ZIGBEE_ACTION_SCHEMA),
+    synchronous=True,
+)
+async def energy_scan_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+ZIGBEE_GROUP_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ZigBeeComponent),
+        cv.Optional(CONF_ENDPOINT, default=1): cv.templatable(cv.int_range(1, 240)),
+        cv.Required(CONF_GROUP): cv.templatable(
+            cv.All(cv.hex_uint16_t, cv.Range(min=0x0001, max=0xFFF7))
+        ),
+    }
+)
+
+
+async def group_action_to_code(config, action_id, template_arg, args, add):
+    var = cg.new_Pvariable(action_id, template_arg, add)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_ENDPOINT], args, cg.uint8)
+    cg.add(var.set_endpoint(template_))
+    template_ = await cg.templatable(config[CONF_GROUP], args, cg.uint16)
+    cg.add(var.set_group(template_))
+    return var
+
+
+@_register_action(
+    "zigbee.add_group", GroupAction, ZIGBEE_GROUP_ACTION_SCHEMA, synchronous=True
+)
+async def add_group_to_code(config, action_id, template_arg, args):
+    return await group_action_to_code(config, action_id, template_arg, args, True)
+
+
+@_register_action(
+    "zigbee.remove_group", GroupAction, ZIGBEE_GROUP_ACTION_SCHEMA, synchronous=True
+)
+async def remove_group_to_code(config, action_id, template_arg, args):
+    return await group_action_to_code(config, action_id, template_arg, args, False)
+
+
+def get_inject_size(attr_type, length):
+    if attr_type in ["CHAR_STRING", "OCTET_STRING"]:
+        return length + 1
+    if attr_type in ["LONG_CHAR_STRING", "LONG_OCTET_STRING"]:
+        return length + 2
+    if attr_type == "BOOL":
+        return 1
+    if attr_type == "SEMI":
+        return 2
+    if attr_type == "SINGLE":
+        return 4
+    if attr_type == "DOUBLE":
+        return 8
+    test = re.match(r"(^[US]?)(\d{1,2})(BITMAP$|BIT$|BIT_ENUM$|$)", attr_type)
+    if test and test.group(2):
+        return int(test.group(2)) // 8
+    raise cv.Invalid(f"Zigbee: type {attr_type} cannot be injected")
+
+
+def validate_inject_payload(config):
+    get_inject_size(config[CONF_TYPE], config[CONF_LENGTH])
+    return config
+
+
+ZIGBEE_INJECT_EVENTS_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ZigBeeComponent),
+        cv.Required(CONF_EVENT): cv.enum(INJECT_EVENTS, lower=True),
+        cv.Optional(CONF_COUNT, default=1000): cv.int_range(1, 1000000),
+        cv.Optional(CONF_RATE, default=100): cv.int_range(0, 100000),
+        cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+        cv.Required(CONF_CLUSTER): cv.Any(
+            cv.enum(CLUSTER_ID, upper=True), cv.hex_uint16_t
+        ),
+        cv.Required(CONF_ATTRIBUTE): cv.hex_uint16_t,
+        cv.Required(CONF_TYPE): cv.enum(ATTR_TYPE, upper=True),
+        cv.Optional(CONF_LENGTH, default=0): cv.int_range(0, 254),
+    }
+).add_extra(validate_inject_payload)
+
+
+@_register_action(
+    "zigbee.inject_events",
+    InjectEventsAction,
+    ZIGBEE_INJECT_EVENTS_SCHEMA,
+    synchronous=True,
+)
+async def inject_events_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_ZIGBEE_INJECT")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(
+        var.set_config(
+            cg.StructInitializer(
+                ZBInjectConfig,
+                ("event", config[CONF_EVENT]),
+                ("count", config[CONF_COUNT]),
+                ("rate", config[CONF_RATE]),
+                ("endpoint", config[CONF_ENDPOINT]),
+                ("cluster", CLUSTER_ID.get(config[CONF_CLUSTER], config[CONF_CLUSTER])),
+                ("attr_id", config[CONF_ATTRIBUTE]),
+                ("attr_type", ATTR_TYPE[config[CONF_TYPE]]),
+                ("size", get_inject_size(config[CONF_TYPE], config[CONF_LENGTH])),
+            )
+        )
+    )
+    return var
+
+
+ZIGBEE_BENCHMARK_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ZigBeeComponent),
+        cv.Optional(CONF_COUNT, default=200): cv.int_range(1, 2000),
+        cv.Optional(CONF_EVENTS, default=list(INJECT_EVENTS)): cv.ensure_list(
+            cv.enum(INJECT_EVENTS, lower=True)
+        ),
+        cv.Optional(
+            CONF_PAYLOADS,
+            default=[
+                {CONF_TYPE: "BOOL"},
+                {CONF_TYPE: "U16"},
+                {CONF_TYPE: "SINGLE"},
+                {CONF_TYPE: "CHAR_STRING", CONF_LENGTH: 32},
+                {CONF_TYPE: "CHAR_STRING", CONF_LENGTH: 254},
+            ],
+        ): cv.ensure_list(
+            cv.Schema(
+                {
+                    cv.Required(CONF_TYPE): cv.enum(ATTR_TYPE, upper=True),
+                    cv.Optional(CONF_LENGTH, default=0): cv.int_range(0, 254),
+                }
+            ).add_extra(validate_inject_payload)
+        ),
+        cv.Optional(CONF_RATES, default=[100, 1000, 0]): cv.ensure_list(
+            cv.int_range(0, 100000)
+        ),
+        cv.Optional(CONF_CONSUMER_COSTS, default=["0us", "1ms"]): cv.ensure_list(
+            cv.All(
+                cv.positive_time_period_microseconds,
+                cv.Range(max=cv.TimePeriod(milliseconds=100)),
+            )
+        ),
+        cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+        cv.Required(CONF_CLUSTER): cv.Any(
+            cv.enum(CLUSTER_ID, upper=True), cv.hex_uint16_t
+        ),
+        cv.Required(CONF_ATTRIBUTE): cv.hex_uint16_t,
+    }
+)
+
+
+@_register_action(
+    "zigbee.benchmark",
+    BenchmarkAction,
+    ZIGBEE_BENCHMARK_SCHEMA,
+    synchronous=True,
+)
+async def benchmark_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_ZIGBEE_INJECT")
+    cg.add_define("USE_ZIGBEE_BENCHMARK")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_count(config[CONF_COUNT]))
+    cg.add(
+        var.set_target(
+            config[CONF_ENDPOINT],
+            CLUSTER_ID.get(config[CONF_CLUSTER], config[CONF_CLUSTER]),
+            config[CONF_ATTRIBUTE],
+        )
+    )
+    for event in config[CONF_EVENTS]:
+        cg.add(var.add_event(event))
+    for payload in config[CONF_PAYLOADS]:
+        cg.add(
+            var.add_payload(
+                ATTR_TYPE[payload[CONF_TYPE]],
+                get_inject_size(payload[CONF_TYPE], payload[CONF_LENGTH]),
+            )
+        )
+    for rate in config[CONF_RATES]:
+        cg.add(var.add_rate(rate))
+    for cost in config[CONF_CONSUMER_COSTS]:
+        cg.add(var.add_cost(cost.total_microseconds))
+    return var
+
+
+def validate_trace_data(value):
+    value = cv.string_strict(value)
+    # log lines of zigbee.trace_dump or plain hex
+    lines = re.findall(r"trace [0-9A-F]{4}: ([0-9a-f]+)", value)
+    data = "".join(lines) if lines else re.sub(r"\s", "", value)
+    try:
+        return list(bytes.fromhex(data))
+    except ValueError as err:
+        raise cv.Invalid(f"Invalid trace data: {err}") from err
+
+
+@_register_action(
+    "zigbee.dump_attribute_stats",
+    AttributeStatsAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ZigBeeComponent),
+            cv.Optional(CONF_COUNT, default=0): cv.int_range(0, 255),
+        }
+    ),
+    synchronous=True,
+)
+async def attribute_stats_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_ZIGBEE_ATTR_STATS")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_count(config[CONF_COUNT]))
+    return var
+
+
+@_register_action(
+    "zigbee.trace_dump",
+    TraceDumpAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ZigBeeComponent),
+            cv.Optional(CONF_CLEAR, default=False): cv.boolean,
+        }
+    ),
+    synchronous=True,
+)
+async def trace_dump_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_ZIGBEE_INJECT")
+    cg.add_define("USE_ZIGBEE_TRACE")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_clear(config[CONF_CLEAR]))
+    return var
+
+
+@_register_action(
+    "zigbee.trace_replay",
+    TraceReplayAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ZigBeeComponent),
+            cv.Optional(CONF_SPEED, default=1.0): cv.float_range(min=0, max=1000),
+            cv.Optional(CONF_DATA): validate_trace_data,
+            cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+        }
+    ),
+    synchronous=True,
+)
+async def trace_replay_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_ZIGBEE_INJECT")
+    cg.add_define("USE_ZIGBEE_TRACE")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_speed(config[CONF_SPEED]))
+    if data := config.get(CONF_DATA):
+        prog_arr = cg.progmem_array(config[CONF_RAW_DATA_ID], data)
+        cg.add(var.set_data(prog_arr, len(data)))
+    return var
+
+
 ZIGBEE_ATTRIBUTE_ACTION_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.use_id(ZigBeeAttribute),
@@ -713,3 +1428,254 @@ async def zigbee_report_attr_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg)
     await cg.register_parented(var, config[CONF_ID])
     return var
+
+
+ON_OFF_COMMANDS = {"off": 0x00, "on": 0x01, "toggle": 0x02}
+LEVEL_MODES = {"up": 0x00, "down": 0x01}
+
+ZIGBEE_CLIENT_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ZigBeeComponent),
+        cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+        cv.Optional(CONF_GROUP): cv.hex_uint16_t,
+        cv.Optional(CONF_ADDRESS): cv.hex_uint16_t,
+        cv.Optional(CONF_DESTINATION_ENDPOINT, default=1): cv.int_range(1, 240),
+    }
+)
+
+
+def client_action_schema(schema):
+    return cv.All(
+        ZIGBEE_CLIENT_ACTION_SCHEMA.extend(schema),
+        cv.has_at_most_one_key(CONF_GROUP, CONF_ADDRESS),
+    )
+
+
+async def client_action_to_code(config, action_id, template_arg):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    if CONF_GROUP in config:
+        mode = cg.RawExpression("ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT")
+        address, dst_endpoint = config[CONF_GROUP], 0
+    elif CONF_ADDRESS in config:
+        mode = cg.RawExpression("ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT")
+        address, dst_endpoint = config[CONF_ADDRESS], config[CONF_DESTINATION_ENDPOINT]
+    else:
+        # bound devices from the binding table of the source endpoint
+        mode = cg.RawExpression("ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT")
+        address, dst_endpoint = 0, 0
+    cg.add(var.set_target(config[CONF_ENDPOINT], mode, address, dst_endpoint))
+    return var
+
+
+@_register_action(
+    "zigbee.on_off",
+    OnOffCommandAction,
+    client_action_schema(
+        {
+            cv.Optional(CONF_COMMAND, default="toggle"): cv.enum(
+                ON_OFF_COMMANDS, lower=True
+            ),
+        }
+    ),
+    synchronous=True,
+)
+async def on_off_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    cg.add(var.set_command(config[CONF_COMMAND]))
+    return var
+
+
+@_register_action(
+    "zigbee.move_to_level",
+    MoveToLevelCommandAction,
+    client_action_schema(
+        {
+            cv.Required(CONF_LEVEL): cv.templatable(cv.uint8_t),
+            cv.Optional(CONF_TRANSITION_LENGTH, default="0s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+        }
+    ),
+    synchronous=True,
+)
+async def move_to_level_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    template_ = await cg.templatable(config[CONF_LEVEL], args, cg.uint8)
+    cg.add(var.set_level(template_))
+    template_ = await cg.templatable(config[CONF_TRANSITION_LENGTH], args, cg.uint32)
+    cg.add(var.set_transition_length(template_))
+    return var
+
+
+@_register_action(
+    "zigbee.level_move",
+    LevelMoveCommandAction,
+    client_action_schema(
+        {
+            cv.Required(CONF_MODE): cv.enum(LEVEL_MODES, lower=True),
+            cv.Optional(CONF_RATE, default=0xFF): cv.templatable(cv.uint8_t),
+        }
+    ),
+    synchronous=True,
+)
+async def level_move_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    cg.add(var.set_mode(config[CONF_MODE]))
+    template_ = await cg.templatable(config[CONF_RATE], args, cg.uint8)
+    cg.add(var.set_rate(template_))
+    return var
+
+
+@_register_action(
+    "zigbee.level_step",
+    LevelStepCommandAction,
+    client_action_schema(
+        {
+            cv.Required(CONF_MODE): cv.enum(LEVEL_MODES, lower=True),
+            cv.Required(CONF_STEP_SIZE): cv.templatable(cv.uint8_t),
+            cv.Optional(CONF_TRANSITION_LENGTH, default="0s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+        }
+    ),
+    synchronous=True,
+)
+async def level_step_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    cg.add(var.set_mode(config[CONF_MODE]))
+    template_ = await cg.templatable(config[CONF_STEP_SIZE], args, cg.uint8)
+    cg.add(var.set_step_size(template_))
+    template_ = await cg.templatable(config[CONF_TRANSITION_LENGTH], args, cg.uint32)
+    cg.add(var.set_transition_length(template_))
+    return var
+
+
+@_register_action(
+    "zigbee.move_to_color",
+    MoveToColorCommandAction,
+    client_action_schema(
+        {
+            cv.Required(CONF_COLOR_X): cv.templatable(cv.zero_to_one_float),
+            cv.Required(CONF_COLOR_Y): cv.templatable(cv.zero_to_one_float),
+            cv.Optional(CONF_TRANSITION_LENGTH, default="0s"): cv.templatable(
+                cv.positive_time_period_milliseconds
+            ),
+        }
+    ),
+    synchronous=True,
+)
+async def move_to_color_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    template_ = await cg.templatable(config[CONF_COLOR_X], args, cg.float_)
+    cg.add(var.set_x(template_))
+    template_ = await cg.templatable(config[CONF_COLOR_Y], args, cg.float_)
+    cg.add(var.set_y(template_))
+    template_ = await cg.templatable(config[CONF_TRANSITION_LENGTH], args, cg.uint32)
+    cg.add(var.set_transition_length(template_))
+    return var
+
+
+@_register_action(
+    "zigbee.recall_scene",
+    RecallSceneCommandAction,
+    client_action_schema(
+        {
+            cv.Optional(CONF_GROUP_ID, default=0): cv.templatable(cv.hex_uint16_t),
+            cv.Required(CONF_SCENE): cv.templatable(cv.uint8_t),
+        }
+    ),
+    synchronous=True,
+)
+async def recall_scene_command_to_code(config, action_id, template_arg, args):
+    var = await client_action_to_code(config, action_id, template_arg)
+    template_ = await cg.templatable(config[CONF_GROUP_ID], args, cg.uint16)
+    cg.add(var.set_group_id(template_))
+    template_ = await cg.templatable(config[CONF_SCENE], args, cg.uint8)
+    cg.add(var.set_scene_id(template_))
+    return var
+
+
+def validate_write_type(value):
+    value = cv.enum(ATTR_TYPE, upper=True)(value)
+    if value in VARIABLE_SIZE_TYPES or value == "128_BIT_KEY":
+        raise cv.Invalid("Only fixed size attributes can be written remotely.")
+    return value
+
+
+ZIGBEE_REMOTE_ATTR_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ZigBeeComponent),
+        cv.Optional(CONF_ADDRESS, default=0x0000): cv.templatable(cv.hex_uint16_t),
+        cv.Optional(CONF_ENDPOINT, default=1): cv.int_range(1, 240),
+        cv.Required(CONF_CLUSTER): cv.Any(
+            cv.enum(CLUSTER_ID, upper=True), cv.hex_uint16_t
+        ),
+        cv.Required(CONF_ATTRIBUTE): cv.hex_uint16_t,
+        cv.Optional(CONF_ON_RESPONSE): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(
+                    ZigBeeAttrResponseTrigger
+                ),
+            }
+        ),
+    }
+)
+
+
+async def remote_attr_action_to_code(var, config, args):
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_ADDRESS], args, cg.uint16)
+    cg.add(var.set_address(template_))
+    cg.add(
+        var.set_attribute(
+            config[CONF_ENDPOINT],
+            CLUSTER_ID.get(config[CONF_CLUSTER], config[CONF_CLUSTER]),
+            config[CONF_ATTRIBUTE],
+        )
+    )
+    for conf in config.get(CONF_ON_RESPONSE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID])
+        await automation.build_automation(
+            trigger,
+            [
+                (cg.uint8, "status"),
+                (cg.global_ns.struct("esp_zb_zcl_attribute_t"), "x"),
+            ],
+            conf,
+        )
+        cg.add(var.add_response_trigger(trigger))
+
+
+@_register_action(
+    "zigbee.read_attribute",
+    ReadAttrAction,
+    ZIGBEE_REMOTE_ATTR_SCHEMA,
+    synchronous=True,
+)
+async def read_attribute_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await remote_attr_action_to_code(var, config, args)
+    return var
+
+
+@_register_action(
+    "zigbee.write_attribute",
+    WriteAttrAction,
+    ZIGBEE_REMOTE_ATTR_SCHEMA.extend(
+        {
+            cv.Required(CONF_TYPE): validate_write_type,
+            cv.Required(CONF_VALUE): cv.templatable(cv.valid),
+        }
+    ),
+    synchronous=True,
+)
+async def write_attribute_to_code(config, action_id, template_arg, args):
+    value_type = get_c_type(config[CONF_TYPE])
+    template_arg = cg.TemplateArguments(value_type, *template_arg.args)
+    var = cg.new_Pvariable(action_id, template_arg)
+    await remote_attr_action_to_code(var, config, args)
+    cg.add(var.set_attr_type(ATTR_TYPE[config[CONF_TYPE]]))
+    template_ = await cg.templatable(config[CONF_VALUE], args, value_type)
+    cg.add(var.set_value(template_))
+    return var
@@ -34,6 +34,304 @@ template<typename... Ts> class ReportAction : public Action<Ts...>, public Paren
 #endif
 };
 
+template<typename... Ts> class EnergyScanAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->start_energy_scan(); }
+#else
+  void play(Ts... x) override { this->parent_->start_energy_scan(); }
+#endif
+};
+
+#ifdef USE_ZIGBEE_INJECT
+template<typename... Ts> class InjectEventsAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_config(const ZBInjectConfig &config) { this->config_ = config; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->inject_events(this->config_); }
+#else
+  void play(Ts... x) override { this->parent_->inject_events(this->config_); }
+#endif
+
+ protected:
+  ZBInjectConfig config_{};
+};
+#endif
+
+#ifdef USE_ZIGBEE_BENCHMARK
+template<typename... Ts> class BenchmarkAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_count(uint32_t count) { this->config_.count = count; }
+  void set_target(uint8_t endpoint, uint16_t cluster, uint16_t attr_id) {
+    this->config_.endpoint = endpoint;
+    this->config_.cluster = cluster;
+    this->config_.attr_id = attr_id;
+  }
+  void add_event(ZBInjectEvent event) { this->config_.events.push_back(event); }
+  void add_payload(uint8_t attr_type, uint16_t size) { this->config_.payloads.push_back({attr_type, size}); }
+  void add_rate(uint32_t rate) { this->config_.rates.push_back(rate); }
+  void add_cost(uint32_t cost) { this->config_.costs.push_back(cost); }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->run_benchmark(this->config_); }
+#else
+  void play(Ts... x) override { this->parent_->run_benchmark(this->config_); }
+#endif
+
+ protected:
+  ZBBenchmarkConfig config_{};
+};
+#endif
+
+#ifdef USE_ZIGBEE_ATTR_STATS
+template<typename... Ts> class AttributeStatsAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_count(uint8_t count) { this->count_ = count; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->dump_attribute_stats(this->count_); }
+#else
+  void play(Ts... x) override { this->parent_->dump_attribute_stats(this->count_); }
+#endif
+
+ protected:
+  uint8_t count_{0};
+};
+#endif
+
+#ifdef USE_ZIGBEE_TRACE
+template<typename... Ts> class TraceDumpAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_clear(bool clear) { this->clear_ = clear; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->dump_trace(this->clear_); }
+#else
+  void play(Ts... x) override { this->parent_->dump_trace(this->clear_); }
+#endif
+
+ protected:
+  bool clear_{false};
+};
+
+template<typename... Ts> class TraceReplayAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_speed(float speed) { this->speed_ = speed; }
+  void set_data(const uint8_t *data, size_t size) {
+    this->data_ = data;
+    this->size_ = size;
+  }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->replay_(); }
+#else
+  void play(Ts... x) override { this->replay_(); }
+#endif
+
+ protected:
+  // without data the recorded events are replayed
+  void replay_() {
+    this->parent_->replay_trace(std::vector<uint8_t>(this->data_, this->data_ + this->size_), this->speed_);
+  }
+
+  float speed_{1.0f};
+  const uint8_t *data_{nullptr};
+  size_t size_{0};
+};
+#endif
+
+template<typename... Ts> class GroupAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  explicit GroupAction(bool add) : add_(add) {}
+  TEMPLATABLE_VALUE(uint8_t, endpoint)
+  TEMPLATABLE_VALUE(uint16_t, group)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    if (this->add_) {
+      this->parent_->add_group(this->endpoint_.value(x...), this->group_.value(x...));
+    } else {
+      this->parent_->remove_group(this->endpoint_.value(x...), this->group_.value(x...));
+    }
+  }
+
+ protected:
+  bool add_;
+};
+
+template<typename... Ts> class ClientCommandAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  void set_target(uint8_t src_endpoint, uint8_t address_mode, uint16_t address, uint8_t dst_endpoint) {
+    this->target_ = ZBTarget{src_endpoint, address_mode, address, dst_endpoint};
+  }
+
+ protected:
+  ZBTarget target_{};
+};
+
+template<typename... Ts> class OnOffCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  void set_command(uint8_t command) { this->command_ = command; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override { this->parent_->send_on_off(this->target_, this->command_); }
+#else
+  void play(Ts... x) override { this->parent_->send_on_off(this->target_, this->command_); }
+#endif
+
+ protected:
+  uint8_t command_;
+};
+
+template<typename... Ts> class MoveToLevelCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, level)
+  TEMPLATABLE_VALUE(uint32_t, transition_length)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    this->parent_->send_move_to_level(this->target_, this->level_.value(x...),
+                                      this->transition_length_.value(x...) / 100);
+  }
+};
+
+template<typename... Ts> class LevelMoveCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  void set_mode(uint8_t mode) { this->mode_ = mode; }
+  TEMPLATABLE_VALUE(uint8_t, rate)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    this->parent_->send_level_move(this->target_, this->mode_, this->rate_.value(x...));
+  }
+
+ protected:
+  uint8_t mode_;
+};
+
+template<typename... Ts> class LevelStepCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  void set_mode(uint8_t mode) { this->mode_ = mode; }
+  TEMPLATABLE_VALUE(uint8_t, step_size)
+  TEMPLATABLE_VALUE(uint32_t, transition_length)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    this->parent_->send_level_step(this->target_, this->mode_, this->step_size_.value(x...),
+                                   this->transition_length_.value(x...) / 100);
+  }
+
+ protected:
+  uint8_t mode_;
+};
+
+template<typename... Ts> class MoveToColorCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  TEMPLATABLE_VALUE(float, x)
+  TEMPLATABLE_VALUE(float, y)
+  TEMPLATABLE_VALUE(uint32_t, transition_length)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    // CIE coordinates are x * 65536, limited to 0xFEFF
+    this->parent_->send_move_to_color(
+        this->target_, (uint16_t) clamp(this->x_.value(x...) * 65536.0f, 0.0f, (float) 0xFEFF),
+        (uint16_t) clamp(this->y_.value(x...) * 65536.0f, 0.0f, (float) 0xFEFF),
+        this->transition_length_.value(x...) / 100);
+  }
+};
+
+template<typename... Ts> class RecallSceneCommandAction : public ClientCommandAction<Ts...> {
+ public:
+  TEMPLATABLE_VALUE(uint16_t, group_id)
+  TEMPLATABLE_VALUE(uint8_t, scene_id)
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    this->parent_->send_recall_scene(this->target_, this->group_id_.value(x...), this->scene_id_.value(x...));
+  }
+};
+
+class ZigBeeAttrResponseTrigger : public Trigger<uint8_t, esp_zb_zcl_attribute_t> {};
+
+template<typename... Ts> class RemoteAttrAction : public Action<Ts...>, public Parented<ZigBeeComponent> {
+ public:
+  TEMPLATABLE_VALUE(uint16_t, address)
+  void set_attribute(uint8_t endpoint, uint16_t cluster, uint16_t attr_id) {
+    this->endpoint_ = endpoint;
+    this->cluster_ = cluster;
+    this->attr_id_ = attr_id;
+  }
+  void add_response_trigger(ZigBeeAttrResponseTrigger *trigger) { this->response_triggers_.push_back(trigger); }
+
+ protected:
+  zb_attr_callback_t get_callback_() {
+    if (this->response_triggers_.empty()) {
+      return nullptr;
+    }
+    return [this](uint8_t status, const esp_zb_zcl_attribute_t *attribute) {
+      for (auto *trigger : this->response_triggers_) {
+        trigger->trigger(status, attribute != nullptr ? *attribute : esp_zb_zcl_attribute_t{});
+      }
+    };
+  }
+  uint8_t endpoint_;
+  uint16_t cluster_;
+  uint16_t attr_id_;
+  std::vector<ZigBeeAttrResponseTrigger *> response_triggers_;
+};
+
+template<typename... Ts> class ReadAttrAction : public RemoteAttrAction<Ts...> {
+ public:
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    this->parent_->read_attribute(this->address_.value(x...), this->endpoint_, this->cluster_, this->attr_id_,
+                                  this->get_callback_());
+  }
+};
+
+template<typename T, typename... Ts> class WriteAttrAction : public RemoteAttrAction<Ts...> {
+ public:
+  TEMPLATABLE_VALUE(T, value)
+  void set_attr_type(uint8_t attr_type) { this->attr_type_ = attr_type; }
+
+#if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
+  void play(const Ts &...x) override {
+#else
+  void play(Ts... x) override {
+#endif
+    uint8_t value[sizeof(uint64_t)] = {};
+    zcl_encode_value(this->attr_type_, this->value_.value(x...), value);
+    this->parent_->write_attribute(this->address_.value(x...), this->endpoint_, this->cluster_, this->attr_id_,
+                                   this->attr_type_, value, this->get_callback_());
+  }
+
+ protected:
+  uint8_t attr_type_;
+};
+
 template<typename... Ts> class ReportAttrAction : public Action<Ts...>, public Parented<ZigBeeAttribute> {
  public:
 #if ESPHOME_VERSION_CODE >= VERSION_CODE(2025, 11, 0)
@@ -58,19 +356,14 @@ template<typename T, typename... Ts> class SetAttrAction : public Action<Ts...>
   ZigBeeAttribute *parent_;
 };
 
-template<typename Ts> class ZigBeeOnValueTrigger : public Trigger<Ts>, public Component {
+template<typename Ts>
+class ZigBeeOnValueTrigger : public Trigger<Ts, ZBRxInfo>, public Component, public ZBValueListener<Ts> {
  public:
   explicit ZigBeeOnValueTrigger(ZigBeeAttribute *parent) : parent_(parent) {}
-  void setup() override {
-    this->parent_->add_on_value_callback([this](esp_zb_zcl_attribute_t attribute) { this->on_value_(attribute); });
-  }
+  void setup() override { this->parent_->add_value_listener(this); }
+  void on_value(const Ts &value) override { this->trigger(value, parent_->last_rx()); }
 
  protected:
-  void on_value_(esp_zb_zcl_attribute_t attribute) {
-    if (attribute.data.type == parent_->attr_type() && attribute.data.value) {
-      this->trigger(get_value_by_type<Ts>(parent_->attr_type(), attribute.data.value));
-    }
-  }
   ZigBeeAttribute *parent_;
 };
 
@@ -78,75 +371,44 @@ template<typename T> struct ZigBeeReportData {
   T value;
   esp_zb_zcl_addr_t src_address;
   uint8_t src_endpoint;
+  uint32_t received;  // millis() at reception
+  uint8_t lqi;        // 0 if unknown
+  int8_t rssi;        // ZB_RX_RSSI_UNKNOWN if unknown
 };
 
-template<typename T> class ZigBeeOnReportTrigger : public Trigger<ZigBeeReportData<T>>, public Component {
+template<typename T>
+class ZigBeeOnReportTrigger : public Trigger<ZigBeeReportData<T>>, public Component, public ZBReportListener<T> {
  public:
   explicit ZigBeeOnReportTrigger(ZigBeeAttribute *parent) : parent_(parent) {}
+  void add_source_address(uint16_t address) { this->filter_.addresses.push_back(address); }
+  void add_source_ieee_address(uint64_t ieee_address) { this->filter_.ieee_addresses.push_back(ieee_address); }
+  void add_source_endpoint(uint8_t endpoint) { this->filter_.endpoints.push_back(endpoint); }
   void setup() override {
-    this->parent_->add_on_report_callback(
-        [this](esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) {
-          this->on_report_(attribute, src_address, src_endpoint);
-        });
+    this->parent_->add_report_listener(this->filter_, this);
+    this->filter_ = {};
+  }
+  void on_report(const T &value, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) override {
+    this->trigger(ZigBeeReportData<T>{
+        .value = value,
+        .src_address = src_address,
+        .src_endpoint = src_endpoint,
+        .received = parent_->last_rx().received,
+        .lqi = parent_->last_rx().lqi,
+        .rssi = parent_->last_rx().rssi,
+    });
   }
 
  protected:
-  void on_report_(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) {
-    if (attribute.data.type == parent_->attr_type() && attribute.data.value) {
-      this->trigger(ZigBeeReportData<T>{
-          .value = get_value_by_type<T>(parent_->attr_type(), attribute.data.value),
-          .src_address = src_address,
-          .src_endpoint = src_endpoint,
-      });
-    }
-  }
   ZigBeeAttribute *parent_;
+  ReportFilter filter_;
 };
 
-template<class T> T get_value_by_type(uint8_t attr_type, void *data) {
-  switch (attr_type) {
-    case ESP_ZB_ZCL_ATTR_TYPE_SEMI:
-      return 0;  //(T) * (std::float16_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_ARRAY:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ARRAY:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_32BIT_ARRAY:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_STRUCTURE:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_SET:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_BAG:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
-      return (T) * (uint32_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_DATE:
-      return (T) * (uint32_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
-      return (T) * (uint32_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_CLUSTER_ID:
-      return (T) * (uint16_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID:
-      return (T) * (uint16_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_BACNET_OID:
-      return 0;
-    case ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR:
-      return (T) * (uint64_t *) data;
-    case ESP_ZB_ZCL_ATTR_TYPE_128_BIT_KEY:
-      return 0;
-    default:
-      return *(T *) data;
-  }
-}
+class ZigBeeOnCommandTrigger : public Trigger<const ZBCommand &> {
+ public:
+  ZigBeeOnCommandTrigger(ZigBeeComponent *parent, uint8_t endpoint, uint16_t cluster, uint8_t command) {
+    parent->add_command_handler(endpoint, cluster, command, [this](const ZBCommand &cmd) { this->trigger(cmd); });
+  }
+};
 
 float get_r_from_xy(float x, float y);
 float get_g_from_xy(float x, float y);
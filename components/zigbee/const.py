@@ -24,6 +24,87 @@ CONF_TRUST_CENTER_KEY = "trust_center_key"
 CONF_DEVICE_VERSION = "device_version"
 CONF_SLEEPY = "sleepy"
 CONF_KEEP_ALIVE = "keep_alive"
+CONF_MAX_RETRIES = "max_retries"
+CONF_MAX_UPDATE_INTERVAL = "max_update_interval"
+CONF_SERVER_ENDPOINT = "server_endpoint"
+CONF_SOURCE = "source"
+CONF_SOURCE_ENDPOINT = "source_endpoint"
+CONF_IEEE_ADDRESS = "ieee_address"
+CONF_MAX_CHILDREN = "max_children"
+CONF_NETWORK_SIZE = "network_size"
+CONF_IO_BUFFER_SIZE = "io_buffer_size"
+CONF_SCHEDULER_QUEUE_SIZE = "scheduler_queue_size"
+CONF_CHILD_COUNT = "child_count"
+CONF_NEIGHBOR_COUNT = "neighbor_count"
+CONF_LQI_MIN = "lqi_min"
+CONF_LQI_AVG = "lqi_avg"
+CONF_RSSI_MIN = "rssi_min"
+CONF_RSSI_AVG = "rssi_avg"
+CONF_ENERGY_SCAN = "energy_scan"
+CONF_ON_BOOT = "on_boot"
+CONF_PREFERRED_CHANNELS = "preferred_channels"
+CONF_ON_ENERGY_SCAN = "on_energy_scan"
+CONF_CHANNEL_ENERGY = "channel_energy"
+CONF_CHANNEL_MASK = "channel_mask"
+CONF_COEXISTENCE = "coexistence"
+CONF_POLICY = "policy"
+CONF_WINDOW = "window"
+CONF_PERIOD = "period"
+CONF_TX_TOTAL = "tx_total"
+CONF_TX_FAILURES = "tx_failures"
+CONF_TX_RETRIES = "tx_retries"
+CONF_CCA_FAILURES = "cca_failures"
+CONF_MAC_DROPS = "mac_drops"
+CONF_COEX_BOOSTS = "coex_boosts"
+CONF_ON_COMMAND = "on_command"
+CONF_COMMAND = "command"
+CONF_GROUP = "group"
+CONF_DESTINATION_ENDPOINT = "destination_endpoint"
+CONF_LEVEL = "level"
+CONF_RATE = "rate"
+CONF_STEP_SIZE = "step_size"
+CONF_SCENE = "scene"
+CONF_GROUP_ID = "group_id"
+CONF_GROUPS = "groups"
+CONF_SCENES = "scenes"
+CONF_COLOR_X = "x"
+CONF_COLOR_Y = "y"
+CONF_COMMAND_TIMEOUT = "command_timeout"
+CONF_MIRROR = "mirror"
+CONF_TTL = "ttl"
+CONF_PERSIST_INTERVAL = "persist_interval"
+CONF_NVS_WRITES = "nvs_writes"
+CONF_MANUFACTURER_CODE = "manufacturer_code"
+CONF_IMAGE_TYPE = "image_type"
+CONF_FILE_VERSION = "file_version"
+CONF_BLOCK_SIZE = "block_size"
+CONF_QUERY_INTERVAL = "query_interval"
+CONF_CMD_SENT = "cmd_sent"
+CONF_CMD_DELIVERED = "cmd_delivered"
+CONF_CMD_FAILED = "cmd_failed"
+CONF_CMD_TIMEOUTS = "cmd_timeouts"
+CONF_CMD_LATENCY = "cmd_latency"
+CONF_CMD_LATENCY_MAX = "cmd_latency_max"
+CONF_ATTRIBUTE = "attribute"
+CONF_ON_RESPONSE = "on_response"
+CONF_EVENTS = "events"
+CONF_PAYLOADS = "payloads"
+CONF_RATES = "rates"
+CONF_CONSUMER_COSTS = "consumer_costs"
+CONF_TRACE = "trace"
+CONF_CLEAR = "clear"
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_ATTRIBUTE_STATS = "attribute_stats"
+CONF_ATTR_TRAFFIC = "attr_traffic"
+CONF_ATTR_LOCK_FAILURES = "attr_lock_failures"
+CONF_BUSIEST_ATTRIBUTES = "busiest_attributes"
+CONF_TASK = "task"
+CONF_STACK_SIZE = "stack_size"
+CONF_TASK_STACK_FREE = "task_stack_free"
+CONF_HEAP_MIN_FREE = "heap_min_free"
+CONF_FAST_OUTPUT = "fast_output"
+CONF_FAST_PATH_LATENCY = "fast_path_latency"
+CONF_LOOP_PATH_LATENCY = "loop_path_latency"
 
 # dummies for upstream compatibility
 binary_sensor_ns = cg.esphome_ns.namespace("binary_sensor")
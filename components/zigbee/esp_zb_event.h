@@ -2,14 +2,32 @@
 
 #ifdef USE_ESP32
 
+#include <algorithm>
 #include <cstddef>  // for offsetof
+#include <cstdint>
+#include <cstdlib>  // for malloc
 #include <cstring>  // for memcpy
 #include "esp_zigbee_core.h"
 #include "zboss_api.h"
 #include "ha/esp_zigbee_ha_standard.h"
+#include "zigbee_codec.h"
 
 namespace esphome::zigbee {
 
+// Largest custom cluster command payload passed through the event queue, longer commands are rejected
+static constexpr uint8_t MAX_ZB_CMD_PAYLOAD = 64;
+// Largest packed scene, entries of cluster (2), attribute id (2), type (1) and the value
+static constexpr uint8_t MAX_ZB_SCENE_DATA = 64;
+
+static constexpr int8_t ZB_RX_RSSI_UNKNOWN = INT8_MIN;
+
+// Reception metadata, captured in the Zigbee task when the event is queued
+struct ZBRxInfo {
+  uint32_t received;  // millis() at reception
+  uint8_t lqi;        // 0 if unknown
+  int8_t rssi;        // ZB_RX_RSSI_UNKNOWN if unknown
+};
+
 class ZBEvent {
  public:
   ZBEvent(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute, uint8_t *current_level) {
@@ -27,6 +45,26 @@ class ZBEvent {
     this->init_read_attr_resp_data(info, variables);
   }
 
+  ZBEvent(const esp_zb_zcl_custom_cluster_command_message_t *message) {
+    this->callback_id_ = ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID;
+    this->init_custom_cmd_data(message);
+  }
+
+  ZBEvent(const esp_zb_zcl_cmd_default_resp_message_t *message) {
+    this->callback_id_ = ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID;
+    this->init_default_resp_data(message);
+  }
+
+  ZBEvent(const esp_zb_zcl_cmd_write_attr_resp_message_t *message) {
+    this->callback_id_ = ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID;
+    this->init_write_attr_resp_data(message);
+  }
+
+  ZBEvent(uint8_t endpoint, const uint8_t *scene_data, uint8_t size) {
+    this->callback_id_ = ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID;
+    this->init_scene_recall_data(endpoint, scene_data, size);
+  }
+
   ~ZBEvent() { this->release(); }
 
   ZBEvent() : event_{}, callback_id_(ESP_ZB_CORE_BASIC_RESET_TO_FACTORY_RESET_CB_ID) {}
@@ -49,19 +87,31 @@ class ZBEvent {
         }
         break;
       case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID: {
-        esp_zb_zcl_read_attr_resp_variable_t *var = &(this->event_.read_attr_resp.variables);
+        esp_zb_zcl_read_attr_resp_variable_t *head = &(this->event_.read_attr_resp.variables);
+        esp_zb_zcl_read_attr_resp_variable_t *var = head;
         while (var != nullptr) {
           if (var->attribute.data.value != nullptr &&
               var->attribute.data.value != this->event_.read_attr_resp.inline_data) {
             free(var->attribute.data.value);
             var->attribute.data.value = nullptr;
           }
-          var = var->next;
+          esp_zb_zcl_read_attr_resp_variable_t *next = var->next;
+          if (var != head) {
+            delete var;  // further variables are allocated in init_read_attr_resp_data
+          }
+          var = next;
         }
+        head->next = nullptr;
       }
         // Reset the event data
         this->callback_id_ = ESP_ZB_CORE_BASIC_RESET_TO_FACTORY_RESET_CB_ID;  // or some invalid value
         break;
+      case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        release_payload(this->event_.custom_cmd.data, this->event_.custom_cmd.inline_data);
+        break;
+      case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+        release_payload(this->event_.scene_recall.data, this->event_.scene_recall.inline_data);
+        break;
       default:
         break;
     }
@@ -86,6 +136,30 @@ class ZBEvent {
     this->init_read_attr_resp_data(info, variables);
   }
 
+  void load_custom_cmd_event(const esp_zb_zcl_custom_cluster_command_message_t *message) {
+    this->release();
+    this->callback_id_ = ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID;
+    this->init_custom_cmd_data(message);
+  }
+
+  void load_default_resp_event(const esp_zb_zcl_cmd_default_resp_message_t *message) {
+    this->release();
+    this->callback_id_ = ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID;
+    this->init_default_resp_data(message);
+  }
+
+  void load_write_attr_resp_event(const esp_zb_zcl_cmd_write_attr_resp_message_t *message) {
+    this->release();
+    this->callback_id_ = ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID;
+    this->init_write_attr_resp_data(message);
+  }
+
+  void load_scene_recall_event(uint8_t endpoint, const uint8_t *scene_data, uint8_t size) {
+    this->release();
+    this->callback_id_ = ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID;
+    this->init_scene_recall_data(endpoint, scene_data, size);
+  }
+
   // Disable copy to prevent double-delete
   ZBEvent(const ZBEvent &) = delete;
   ZBEvent &operator=(const ZBEvent &) = delete;
@@ -111,9 +185,35 @@ class ZBEvent {
       esp_zb_zcl_read_attr_resp_variable_t variables;
       uint8_t inline_data[4];  // For small data types
     } read_attr_resp;
+    struct custom_cmd_event {
+      esp_zb_zcl_cmd_info_t info;
+      uint8_t size;
+      uint8_t inline_data[4];  // For small payloads
+      uint8_t *data;           // inline_data or allocated, at most MAX_ZB_CMD_PAYLOAD bytes
+    } custom_cmd;
+    struct default_resp_event {
+      esp_zb_zcl_cmd_info_t info;
+      uint8_t resp_to_cmd;
+      uint8_t status;
+    } default_resp;
+    struct write_attr_resp_event {
+      esp_zb_zcl_cmd_info_t info;
+      uint8_t status;  // first failed attribute, or success for all
+      uint16_t attr_id;
+    } write_attr_resp;
+    struct scene_recall_event {
+      uint8_t endpoint;
+      uint8_t size;
+      uint8_t inline_data[4];  // For small scenes
+      uint8_t *data;           // packed scene, already applied to the attributes, inline_data or allocated
+    } scene_recall;
   } event_;
 
   esp_zb_core_action_callback_id_t callback_id_;
+  ZBRxInfo rx_{};
+#if defined(USE_ZIGBEE_BENCHMARK) || defined(USE_ZIGBEE_TRACE) || defined(USE_ZIGBEE_FAST_PATH)
+  uint32_t queued_{0};  // micros() in enqueue_zb_event
+#endif
 
  private:
   void init_set_attr_value_data(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute,
@@ -127,14 +227,15 @@ class ZBEvent {
     }
     if (attribute.data.value != nullptr) {
       // Copy the attribute value to avoid dangling pointer issues
-      size_t value_size = this->get_attribute_value_size_(attribute.data);
+      size_t value_size = get_value_size(attribute.data);
       if (value_size > 4) {
         this->event_.set_attr.attribute.data.value = malloc(value_size);
         if (this->event_.set_attr.attribute.data.value != nullptr) {
-          memcpy(this->event_.set_attr.attribute.data.value, attribute.data.value, value_size);
+          zcl_copy_value(attribute.data.type, (uint8_t *) this->event_.set_attr.attribute.data.value,
+                         attribute.data.value, value_size);
         }
       } else {
-        memcpy(this->event_.set_attr.inline_data, attribute.data.value, value_size);
+        zcl_copy_value(attribute.data.type, this->event_.set_attr.inline_data, attribute.data.value, value_size);
         this->event_.set_attr.attribute.data.value = this->event_.set_attr.inline_data;
       }
     }
@@ -148,14 +249,16 @@ class ZBEvent {
     this->event_.report_attr.src_endpoint = message->src_endpoint;
     if (message->attribute.data.value != nullptr) {
       // Copy the attribute value to avoid dangling pointer issues
-      size_t value_size = this->get_attribute_value_size_(message->attribute.data);
+      size_t value_size = get_value_size(message->attribute.data);
       if (value_size > 4) {
         this->event_.report_attr.attribute.data.value = malloc(value_size);
         if (this->event_.report_attr.attribute.data.value != nullptr) {
-          memcpy(this->event_.report_attr.attribute.data.value, message->attribute.data.value, value_size);
+          zcl_copy_value(message->attribute.data.type, (uint8_t *) this->event_.report_attr.attribute.data.value,
+                         message->attribute.data.value, value_size);
         }
       } else {
-        memcpy(this->event_.report_attr.inline_data, message->attribute.data.value, value_size);
+        zcl_copy_value(message->attribute.data.type, this->event_.report_attr.inline_data,
+                       message->attribute.data.value, value_size);
         this->event_.report_attr.attribute.data.value = this->event_.report_attr.inline_data;
       }
     }
@@ -163,6 +266,8 @@ class ZBEvent {
 
   void init_read_attr_resp_data(esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_attr_resp_variable_t *variables) {
     this->event_.read_attr_resp.info = info;
+    // failed responses carry no variables, do not leave a stale list for release()
+    this->event_.read_attr_resp.variables = {};
     if (variables == nullptr) {
       return;
     }
@@ -172,15 +277,17 @@ class ZBEvent {
     this->event_.read_attr_resp.variables.attribute.data.size = variables->attribute.data.size;
     // Note: variables is a pointer to a struct/list; deep copy needed
     if (variables->attribute.data.value != nullptr) {
-      size_t value_size = this->get_attribute_value_size_(variables->attribute.data);
+      size_t value_size = get_value_size(variables->attribute.data);
       if (value_size > 4) {
         this->event_.read_attr_resp.variables.attribute.data.value = malloc(value_size);
         if (this->event_.read_attr_resp.variables.attribute.data.value != nullptr) {
-          memcpy(this->event_.read_attr_resp.variables.attribute.data.value, variables->attribute.data.value,
-                 value_size);
+          zcl_copy_value(variables->attribute.data.type,
+                         (uint8_t *) this->event_.read_attr_resp.variables.attribute.data.value,
+                         variables->attribute.data.value, value_size);
         }
       } else {
-        memcpy(this->event_.read_attr_resp.inline_data, variables->attribute.data.value, value_size);
+        zcl_copy_value(variables->attribute.data.type, this->event_.read_attr_resp.inline_data,
+                       variables->attribute.data.value, value_size);
         this->event_.read_attr_resp.variables.attribute.data.value = this->event_.read_attr_resp.inline_data;
       }
     }
@@ -188,124 +295,84 @@ class ZBEvent {
     esp_zb_zcl_read_attr_resp_variable_t *var_last = &(this->event_.read_attr_resp.variables);
     while (var->next != nullptr) {
       var = var->next;
-      size_t value_size = this->get_attribute_value_size_(var->attribute.data);
+      size_t value_size = get_value_size(var->attribute.data);
       var_last->next = new esp_zb_zcl_read_attr_resp_variable_t();
       if (var_last->next != nullptr) {
         var_last->next->attribute.id = var->attribute.id;
         var_last->next->status = var->status;
         var_last->next->attribute.data.type = var->attribute.data.type;
         var_last->next->attribute.data.size = var->attribute.data.size;
-        var_last->next->attribute.data.value = malloc(value_size);
-        if (var_last->next->attribute.data.value != nullptr) {
-          memcpy(var_last->next->attribute.data.value, var->attribute.data.value, value_size);
+        if (var->attribute.data.value != nullptr) {
+          // room for the length of a string clamped to less than its prefix
+          var_last->next->attribute.data.value =
+              malloc(std::max<size_t>(value_size, zcl_length_prefix(var->attribute.data.type)));
+          if (var_last->next->attribute.data.value != nullptr) {
+            zcl_copy_value(var->attribute.data.type, (uint8_t *) var_last->next->attribute.data.value,
+                           var->attribute.data.value, value_size);
+          }
         }
         var_last = var_last->next;
       }
     }
   }
 
-  size_t get_attribute_value_size_(esp_zb_zcl_attribute_data_t data) {
-    // Determine attribute value size based on attribute type (and size)
-    uint8_t len = 0;
-    switch (data.type) {
-      case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
-        return sizeof(bool);
-      case ESP_ZB_ZCL_ATTR_TYPE_U8:
-        return sizeof(uint8_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_U16:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_U24:
-        return 3;  // 24 bits = 3 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_U32:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_U40:
-        return 5;  // 40 bits = 5 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_U48:
-        return 6;  // 48 bits = 6 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_U56:
-        return 7;  // 56 bits = 7 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_U64:
-        return sizeof(uint64_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_S8:
-        return sizeof(int8_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_S16:
-        return sizeof(int16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_S24:
-        return 3;  // 24 bits = 3 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_S32:
-        return sizeof(int32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_S40:
-        return 5;  // 40 bits = 5 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_S48:
-        return 6;  // 48 bits = 6 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_S56:
-        return 7;  // 56 bits = 7 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_S64:
-        return sizeof(int64_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_8BITMAP:
-        return sizeof(uint8_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_16BITMAP:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_24BITMAP:
-        return 3;  // 24 bits = 3 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_32BITMAP:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_40BITMAP:
-        return 5;  // 40 bits = 5 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_48BITMAP:
-        return 6;  // 48 bits = 6 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_56BITMAP:
-        return 7;  // 56 bits = 7 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_64BITMAP:
-        return sizeof(uint64_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_8BIT:
-        return sizeof(uint8_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_16BIT:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_24BIT:
-        return 3;  // 24 bits = 3 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_32BIT:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_40BIT:
-        return 5;  // 40 bits = 5 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_48BIT:
-        return 6;  // 48 bits = 6 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_56BIT:
-        return 7;  // 56 bits = 7 bytes
-      case ESP_ZB_ZCL_ATTR_TYPE_64BIT:
-        return sizeof(uint64_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
-        return sizeof(uint8_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_SEMI:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_SINGLE:
-        return sizeof(float);
-      case ESP_ZB_ZCL_ATTR_TYPE_DOUBLE:
-        return sizeof(double);
-      case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
-        len = *((uint8_t *) data.value);  // first byte is length
-        return len + 1;                   // length byte + string
-      case ESP_ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_DATE:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_CLUSTER_ID:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID:
-        return sizeof(uint16_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_BACNET_OID:
-        return sizeof(uint32_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR:
-        return sizeof(uint64_t);
-      case ESP_ZB_ZCL_ATTR_TYPE_128_BIT_KEY:
-        return 16;  // 128 bits = 16 bytes
-      default:
-        return 0;  // Unknown type
+  void init_custom_cmd_data(const esp_zb_zcl_custom_cluster_command_message_t *message) {
+    this->event_.custom_cmd.info = message->info;
+    uint8_t size = message->data.value != nullptr ? message->data.size : 0;
+    this->event_.custom_cmd.data = copy_payload(message->data.value, &size, this->event_.custom_cmd.inline_data);
+    this->event_.custom_cmd.size = size;
+  }
+
+  void init_default_resp_data(const esp_zb_zcl_cmd_default_resp_message_t *message) {
+    this->event_.default_resp.info = message->info;
+    this->event_.default_resp.resp_to_cmd = message->resp_to_cmd;
+    this->event_.default_resp.status = message->status_code;
+  }
+
+  void init_write_attr_resp_data(const esp_zb_zcl_cmd_write_attr_resp_message_t *message) {
+    this->event_.write_attr_resp.info = message->info;
+    this->event_.write_attr_resp.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+    this->event_.write_attr_resp.attr_id = 0xFFFF;
+    if (message->variables != nullptr) {
+      this->event_.write_attr_resp.status = message->variables->status;
+      this->event_.write_attr_resp.attr_id = message->variables->attribute_id;
+    }
+  }
+
+  void init_scene_recall_data(uint8_t endpoint, const uint8_t *scene_data, uint8_t size) {
+    this->event_.scene_recall.endpoint = endpoint;
+    this->event_.scene_recall.data = copy_payload(scene_data, &size, this->event_.scene_recall.inline_data);
+    this->event_.scene_recall.size = size;
+  }
+
+  // Copies a command or scene payload, up to 4 bytes into inline_data. The result is never null, size is set to 0
+  // if the allocation fails.
+  static uint8_t *copy_payload(const void *payload, uint8_t *size, uint8_t *inline_data) {
+    uint8_t *data = inline_data;
+    if (*size > 4) {
+      data = (uint8_t *) malloc(*size);
+      if (data == nullptr) {
+        *size = 0;
+        return inline_data;
+      }
+    }
+    if (*size > 0) {
+      memcpy(data, payload, *size);
     }
+    return data;
+  }
+
+  static void release_payload(uint8_t *&data, uint8_t *inline_data) {
+    if (data != nullptr && data != inline_data) {
+      free(data);
+    }
+    data = nullptr;
+  }
+
+ public:
+  // Size of the value copied into the event
+  static size_t get_value_size(esp_zb_zcl_attribute_data_t data) {
+    return zcl_value_size(data.type, data.value, data.size);
   }
 };
 }  // namespace esphome::zigbee
@@ -0,0 +1,145 @@
+import esphome.codegen as cg
+from esphome.components import sensor
+import esphome.config_validation as cv
+from esphome.const import (
+    CONF_ID,
+    DEVICE_CLASS_SIGNAL_STRENGTH,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_BYTES,
+    UNIT_DECIBEL_MILLIWATT,
+    UNIT_MILLISECOND,
+)
+from esphome.cpp_generator import get_variable
+
+from ..const import (
+    CONF_ATTR_LOCK_FAILURES,
+    CONF_ATTR_TRAFFIC,
+    CONF_CCA_FAILURES,
+    CONF_CHILD_COUNT,
+    CONF_CMD_DELIVERED,
+    CONF_CMD_FAILED,
+    CONF_CMD_LATENCY,
+    CONF_CMD_LATENCY_MAX,
+    CONF_CMD_SENT,
+    CONF_CMD_TIMEOUTS,
+    CONF_COEX_BOOSTS,
+    CONF_FAST_PATH_LATENCY,
+    CONF_HEAP_MIN_FREE,
+    CONF_LOOP_PATH_LATENCY,
+    CONF_LQI_AVG,
+    CONF_LQI_MIN,
+    CONF_MAC_DROPS,
+    CONF_NEIGHBOR_COUNT,
+    CONF_NVS_WRITES,
+    CONF_RSSI_AVG,
+    CONF_RSSI_MIN,
+    CONF_TASK_STACK_FREE,
+    CONF_TX_FAILURES,
+    CONF_TX_RETRIES,
+    CONF_TX_TOTAL,
+    CONF_ZIGBEE_ID,
+)
+
+DEPENDENCIES = ["zigbee"]
+
+zigbee_ns = cg.esphome_ns.namespace("zigbee")
+ZigbeeSensor = zigbee_ns.class_("ZigbeeSensor", cg.PollingComponent)
+ZigBeeComponent = zigbee_ns.class_("ZigBeeComponent", cg.Component)
+
+_COUNT_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_LQI_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_RSSI_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_DECIBEL_MILLIWATT,
+    accuracy_decimals=0,
+    device_class=DEVICE_CLASS_SIGNAL_STRENGTH,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_TOTAL_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_LATENCY_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+_PATH_LATENCY_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    accuracy_decimals=3,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_BYTES_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_BYTES,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+SENSORS = {
+    CONF_CHILD_COUNT: _COUNT_SCHEMA,
+    CONF_NEIGHBOR_COUNT: _COUNT_SCHEMA,
+    CONF_LQI_MIN: _LQI_SCHEMA,
+    CONF_LQI_AVG: _LQI_SCHEMA,
+    CONF_RSSI_MIN: _RSSI_SCHEMA,
+    CONF_RSSI_AVG: _RSSI_SCHEMA,
+    CONF_TX_TOTAL: _TOTAL_SCHEMA,
+    CONF_TX_FAILURES: _TOTAL_SCHEMA,
+    CONF_TX_RETRIES: _TOTAL_SCHEMA,
+    CONF_CCA_FAILURES: _TOTAL_SCHEMA,
+    CONF_MAC_DROPS: _TOTAL_SCHEMA,
+    CONF_COEX_BOOSTS: _TOTAL_SCHEMA,
+    CONF_CMD_SENT: _TOTAL_SCHEMA,
+    CONF_CMD_DELIVERED: _TOTAL_SCHEMA,
+    CONF_CMD_FAILED: _TOTAL_SCHEMA,
+    CONF_CMD_TIMEOUTS: _TOTAL_SCHEMA,
+    CONF_CMD_LATENCY: _LATENCY_SCHEMA,
+    CONF_CMD_LATENCY_MAX: _LATENCY_SCHEMA,
+    CONF_NVS_WRITES: _TOTAL_SCHEMA,
+    CONF_TASK_STACK_FREE: _BYTES_SCHEMA,
+    CONF_HEAP_MIN_FREE: _BYTES_SCHEMA,
+    CONF_ATTR_TRAFFIC: _TOTAL_SCHEMA,
+    CONF_ATTR_LOCK_FAILURES: _TOTAL_SCHEMA,
+    CONF_FAST_PATH_LATENCY: _PATH_LATENCY_SCHEMA,
+    CONF_LOOP_PATH_LATENCY: _PATH_LATENCY_SCHEMA,
+}
+# summed over the attribute counters, which only exist with USE_ZIGBEE_ATTR_STATS
+ATTR_STATS_SENSORS = [CONF_ATTR_TRAFFIC, CONF_ATTR_LOCK_FAILURES]
+# measured by the fast path, which only exists with USE_ZIGBEE_FAST_PATH
+FAST_PATH_SENSORS = [CONF_FAST_PATH_LATENCY, CONF_LOOP_PATH_LATENCY]
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ZigbeeSensor),
+        cv.GenerateID(CONF_ZIGBEE_ID): cv.use_id(ZigBeeComponent),
+        **{cv.Optional(key): schema for key, schema in SENSORS.items()},
+    }
+).extend(cv.polling_component_schema("60s"))
+
+
+async def to_code(config):
+    zb = await get_variable(config[CONF_ZIGBEE_ID])
+    var = cg.new_Pvariable(config[CONF_ID], zb)
+    await cg.register_component(var, config)
+    if any(key in config for key in ATTR_STATS_SENSORS):
+        cg.add_define("USE_ZIGBEE_ATTR_STATS")
+    if any(key in config for key in FAST_PATH_SENSORS):
+        cg.add_define("USE_ZIGBEE_FAST_PATH")
+    for key in SENSORS:
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
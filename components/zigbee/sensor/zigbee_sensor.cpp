@@ -0,0 +1,162 @@
+#include "zigbee_sensor.h"
+#include "esphome/core/log.h"
+#ifdef USE_ZIGBEE_ATTR_STATS
+#include "../zigbee_attribute.h"
+#endif
+
+namespace esphome {
+namespace zigbee {
+
+void ZigbeeSensor::setup() {
+  if (this->has_tx_sensors_()) {
+    this->zc_->add_on_tx_stats_callback([this]() { this->publish_tx_stats_(); });
+  }
+}
+
+void ZigbeeSensor::update() {
+  // memory watermarks are also published while not joined, e.g. during commissioning
+  if (this->task_stack_free_sensor_ != nullptr)
+    this->task_stack_free_sensor_->publish_state(this->zc_->get_task_stack_free());
+  if (this->heap_min_free_sensor_ != nullptr)
+    this->heap_min_free_sensor_->publish_state(this->zc_->get_heap_min_free());
+  if (!this->zc_->is_connected()) {
+    return;
+  }
+  if (this->child_count_sensor_ != nullptr || this->neighbor_count_sensor_ != nullptr ||
+      this->lqi_min_sensor_ != nullptr || this->lqi_avg_sensor_ != nullptr || this->rssi_min_sensor_ != nullptr ||
+      this->rssi_avg_sensor_ != nullptr) {
+    this->update_neighbors_();
+  }
+  if (this->has_tx_sensors_()) {
+    this->zc_->request_tx_stats();  // published by the callback once the stack answered
+  }
+  this->publish_client_stats_();
+  if (this->nvs_writes_sensor_ != nullptr)
+    this->nvs_writes_sensor_->publish_state(this->zc_->get_persist_writes());
+#ifdef USE_ZIGBEE_ATTR_STATS
+  this->publish_attr_stats_();
+#endif
+#ifdef USE_ZIGBEE_FAST_PATH
+  ZBLatencyStats fast = this->zc_->get_fast_path_latency();
+  if (this->fast_path_latency_sensor_ != nullptr && fast.count > 0)
+    this->fast_path_latency_sensor_->publish_state(fast.avg / 1000.0f);
+  ZBLatencyStats loop = this->zc_->get_loop_path_latency();
+  if (this->loop_path_latency_sensor_ != nullptr && loop.count > 0)
+    this->loop_path_latency_sensor_->publish_state(loop.avg / 1000.0f);
+#endif
+}
+
+#ifdef USE_ZIGBEE_ATTR_STATS
+void ZigbeeSensor::publish_attr_stats_() {
+  if (this->attr_traffic_sensor_ == nullptr && this->attr_lock_failures_sensor_ == nullptr)
+    return;
+  uint32_t traffic = 0;
+  uint32_t lock_failures = 0;
+  for (ZigBeeAttribute *attr : this->zc_->get_busiest_attributes(0)) {
+    traffic += attr->get_stats().total();
+    lock_failures += attr->get_stats().lock_failures;
+  }
+  if (this->attr_traffic_sensor_ != nullptr)
+    this->attr_traffic_sensor_->publish_state(traffic);
+  if (this->attr_lock_failures_sensor_ != nullptr)
+    this->attr_lock_failures_sensor_->publish_state(lock_failures);
+}
+#endif
+
+void ZigbeeSensor::publish_client_stats_() {
+  ClientStats stats = this->zc_->get_client_stats();
+  if (this->cmd_sent_sensor_ != nullptr)
+    this->cmd_sent_sensor_->publish_state(stats.sent);
+  if (this->cmd_delivered_sensor_ != nullptr)
+    this->cmd_delivered_sensor_->publish_state(stats.delivered);
+  if (this->cmd_failed_sensor_ != nullptr)
+    this->cmd_failed_sensor_->publish_state(stats.failed);
+  if (this->cmd_timeouts_sensor_ != nullptr)
+    this->cmd_timeouts_sensor_->publish_state(stats.timeouts);
+  if (stats.delivered == 0)
+    return;
+  if (this->cmd_latency_sensor_ != nullptr)
+    this->cmd_latency_sensor_->publish_state(stats.avg_latency);
+  if (this->cmd_latency_max_sensor_ != nullptr)
+    this->cmd_latency_max_sensor_->publish_state(stats.max_latency);
+}
+
+bool ZigbeeSensor::has_tx_sensors_() {
+  return this->tx_total_sensor_ != nullptr || this->tx_failures_sensor_ != nullptr ||
+         this->tx_retries_sensor_ != nullptr || this->cca_failures_sensor_ != nullptr ||
+         this->mac_drops_sensor_ != nullptr || this->coex_boosts_sensor_ != nullptr;
+}
+
+void ZigbeeSensor::publish_tx_stats_() {
+  TxStats stats = this->zc_->get_tx_stats();
+  if (this->tx_total_sensor_ != nullptr)
+    this->tx_total_sensor_->publish_state(stats.tx_total);
+  if (this->tx_failures_sensor_ != nullptr)
+    this->tx_failures_sensor_->publish_state(stats.tx_failures);
+  if (this->tx_retries_sensor_ != nullptr)
+    this->tx_retries_sensor_->publish_state(stats.tx_retries);
+  if (this->cca_failures_sensor_ != nullptr)
+    this->cca_failures_sensor_->publish_state(stats.cca_failures);
+  if (this->mac_drops_sensor_ != nullptr)
+    this->mac_drops_sensor_->publish_state(stats.drops);
+  if (this->coex_boosts_sensor_ != nullptr)
+    this->coex_boosts_sensor_->publish_state(stats.coex_boosts);
+}
+
+void ZigbeeSensor::update_neighbors_() {
+  NeighborStats stats;
+  if (!this->zc_->get_neighbor_stats(&stats)) {
+    ESP_LOGD(TAG, "Could not read neighbor table, Zigbee stack busy");
+    return;
+  }
+  if (this->child_count_sensor_ != nullptr)
+    this->child_count_sensor_->publish_state(stats.children);
+  if (this->neighbor_count_sensor_ != nullptr)
+    this->neighbor_count_sensor_->publish_state(stats.neighbors);
+  if (stats.neighbors == 0)
+    return;
+  if (this->lqi_min_sensor_ != nullptr)
+    this->lqi_min_sensor_->publish_state(stats.lqi_min);
+  if (this->lqi_avg_sensor_ != nullptr)
+    this->lqi_avg_sensor_->publish_state(stats.lqi_avg);
+  if (this->rssi_min_sensor_ != nullptr)
+    this->rssi_min_sensor_->publish_state(stats.rssi_min);
+  if (this->rssi_avg_sensor_ != nullptr)
+    this->rssi_avg_sensor_->publish_state(stats.rssi_avg);
+}
+
+void ZigbeeSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "Zigbee Sensor:");
+  LOG_SENSOR("  ", "Child Count", this->child_count_sensor_);
+  LOG_SENSOR("  ", "Neighbor Count", this->neighbor_count_sensor_);
+  LOG_SENSOR("  ", "Neighbor LQI Min", this->lqi_min_sensor_);
+  LOG_SENSOR("  ", "Neighbor LQI Avg", this->lqi_avg_sensor_);
+  LOG_SENSOR("  ", "Neighbor RSSI Min", this->rssi_min_sensor_);
+  LOG_SENSOR("  ", "Neighbor RSSI Avg", this->rssi_avg_sensor_);
+  LOG_SENSOR("  ", "TX Total", this->tx_total_sensor_);
+  LOG_SENSOR("  ", "TX Failures", this->tx_failures_sensor_);
+  LOG_SENSOR("  ", "TX Retries", this->tx_retries_sensor_);
+  LOG_SENSOR("  ", "CCA Failures", this->cca_failures_sensor_);
+  LOG_SENSOR("  ", "MAC Drops", this->mac_drops_sensor_);
+  LOG_SENSOR("  ", "Coexistence Boosts", this->coex_boosts_sensor_);
+  LOG_SENSOR("  ", "Commands Sent", this->cmd_sent_sensor_);
+  LOG_SENSOR("  ", "Commands Delivered", this->cmd_delivered_sensor_);
+  LOG_SENSOR("  ", "Commands Failed", this->cmd_failed_sensor_);
+  LOG_SENSOR("  ", "Commands Timed Out", this->cmd_timeouts_sensor_);
+  LOG_SENSOR("  ", "Command Latency", this->cmd_latency_sensor_);
+  LOG_SENSOR("  ", "Command Latency Max", this->cmd_latency_max_sensor_);
+  LOG_SENSOR("  ", "NVS Writes", this->nvs_writes_sensor_);
+  LOG_SENSOR("  ", "Task Stack Free", this->task_stack_free_sensor_);
+  LOG_SENSOR("  ", "Heap Min Free", this->heap_min_free_sensor_);
+#ifdef USE_ZIGBEE_FAST_PATH
+  LOG_SENSOR("  ", "Fast Path Latency", this->fast_path_latency_sensor_);
+  LOG_SENSOR("  ", "Loop Path Latency", this->loop_path_latency_sensor_);
+#endif
+#ifdef USE_ZIGBEE_ATTR_STATS
+  LOG_SENSOR("  ", "Attribute Traffic", this->attr_traffic_sensor_);
+  LOG_SENSOR("  ", "Attribute Lock Failures", this->attr_lock_failures_sensor_);
+#endif
+}
+
+}  // namespace zigbee
+}  // namespace esphome
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "../zigbee.h"
+
+namespace esphome {
+namespace zigbee {
+
+class ZigbeeSensor : public PollingComponent {
+ public:
+  ZigbeeSensor(ZigBeeComponent *zc) : zc_(zc) {}
+  void setup() override;
+  void update() override;
+  void dump_config() override;
+
+  void set_child_count_sensor(sensor::Sensor *sensor) { this->child_count_sensor_ = sensor; }
+  void set_neighbor_count_sensor(sensor::Sensor *sensor) { this->neighbor_count_sensor_ = sensor; }
+  void set_lqi_min_sensor(sensor::Sensor *sensor) { this->lqi_min_sensor_ = sensor; }
+  void set_lqi_avg_sensor(sensor::Sensor *sensor) { this->lqi_avg_sensor_ = sensor; }
+  void set_rssi_min_sensor(sensor::Sensor *sensor) { this->rssi_min_sensor_ = sensor; }
+  void set_rssi_avg_sensor(sensor::Sensor *sensor) { this->rssi_avg_sensor_ = sensor; }
+  void set_tx_total_sensor(sensor::Sensor *sensor) { this->tx_total_sensor_ = sensor; }
+  void set_tx_failures_sensor(sensor::Sensor *sensor) { this->tx_failures_sensor_ = sensor; }
+  void set_tx_retries_sensor(sensor::Sensor *sensor) { this->tx_retries_sensor_ = sensor; }
+  void set_cca_failures_sensor(sensor::Sensor *sensor) { this->cca_failures_sensor_ = sensor; }
+  void set_mac_drops_sensor(sensor::Sensor *sensor) { this->mac_drops_sensor_ = sensor; }
+  void set_coex_boosts_sensor(sensor::Sensor *sensor) { this->coex_boosts_sensor_ = sensor; }
+  void set_cmd_sent_sensor(sensor::Sensor *sensor) { this->cmd_sent_sensor_ = sensor; }
+  void set_cmd_delivered_sensor(sensor::Sensor *sensor) { this->cmd_delivered_sensor_ = sensor; }
+  void set_cmd_failed_sensor(sensor::Sensor *sensor) { this->cmd_failed_sensor_ = sensor; }
+  void set_cmd_timeouts_sensor(sensor::Sensor *sensor) { this->cmd_timeouts_sensor_ = sensor; }
+  void set_cmd_latency_sensor(sensor::Sensor *sensor) { this->cmd_latency_sensor_ = sensor; }
+  void set_cmd_latency_max_sensor(sensor::Sensor *sensor) { this->cmd_latency_max_sensor_ = sensor; }
+  void set_nvs_writes_sensor(sensor::Sensor *sensor) { this->nvs_writes_sensor_ = sensor; }
+  void set_task_stack_free_sensor(sensor::Sensor *sensor) { this->task_stack_free_sensor_ = sensor; }
+  void set_heap_min_free_sensor(sensor::Sensor *sensor) { this->heap_min_free_sensor_ = sensor; }
+#ifdef USE_ZIGBEE_FAST_PATH
+  void set_fast_path_latency_sensor(sensor::Sensor *sensor) { this->fast_path_latency_sensor_ = sensor; }
+  void set_loop_path_latency_sensor(sensor::Sensor *sensor) { this->loop_path_latency_sensor_ = sensor; }
+#endif
+#ifdef USE_ZIGBEE_ATTR_STATS
+  void set_attr_traffic_sensor(sensor::Sensor *sensor) { this->attr_traffic_sensor_ = sensor; }
+  void set_attr_lock_failures_sensor(sensor::Sensor *sensor) { this->attr_lock_failures_sensor_ = sensor; }
+#endif
+
+ protected:
+  void update_neighbors_();
+  bool has_tx_sensors_();
+  void publish_tx_stats_();
+  void publish_client_stats_();
+#ifdef USE_ZIGBEE_ATTR_STATS
+  void publish_attr_stats_();
+#endif
+
+  ZigBeeComponent *zc_;
+  sensor::Sensor *child_count_sensor_{nullptr};
+  sensor::Sensor *neighbor_count_sensor_{nullptr};
+  sensor::Sensor *lqi_min_sensor_{nullptr};
+  sensor::Sensor *lqi_avg_sensor_{nullptr};
+  sensor::Sensor *rssi_min_sensor_{nullptr};
+  sensor::Sensor *rssi_avg_sensor_{nullptr};
+  sensor::Sensor *tx_total_sensor_{nullptr};
+  sensor::Sensor *tx_failures_sensor_{nullptr};
+  sensor::Sensor *tx_retries_sensor_{nullptr};
+  sensor::Sensor *cca_failures_sensor_{nullptr};
+  sensor::Sensor *mac_drops_sensor_{nullptr};
+  sensor::Sensor *coex_boosts_sensor_{nullptr};
+  sensor::Sensor *cmd_sent_sensor_{nullptr};
+  sensor::Sensor *cmd_delivered_sensor_{nullptr};
+  sensor::Sensor *cmd_failed_sensor_{nullptr};
+  sensor::Sensor *cmd_timeouts_sensor_{nullptr};
+  sensor::Sensor *cmd_latency_sensor_{nullptr};
+  sensor::Sensor *cmd_latency_max_sensor_{nullptr};
+  sensor::Sensor *nvs_writes_sensor_{nullptr};
+  sensor::Sensor *task_stack_free_sensor_{nullptr};
+  sensor::Sensor *heap_min_free_sensor_{nullptr};
+#ifdef USE_ZIGBEE_FAST_PATH
+  sensor::Sensor *fast_path_latency_sensor_{nullptr};
+  sensor::Sensor *loop_path_latency_sensor_{nullptr};
+#endif
+#ifdef USE_ZIGBEE_ATTR_STATS
+  sensor::Sensor *attr_traffic_sensor_{nullptr};
+  sensor::Sensor *attr_lock_failures_sensor_{nullptr};
+#endif
+};
+
+}  // namespace zigbee
+}  // namespace esphome
@@ -0,0 +1,68 @@
+import esphome.codegen as cg
+from esphome.components import text_sensor
+import esphome.config_validation as cv
+from esphome.const import (
+    CONF_COUNT,
+    CONF_ID,
+    CONF_UPDATE_INTERVAL,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+)
+from esphome.cpp_generator import get_variable
+
+from ..const import (
+    CONF_BUSIEST_ATTRIBUTES,
+    CONF_CHANNEL_ENERGY,
+    CONF_CHANNEL_MASK,
+    CONF_ZIGBEE_ID,
+)
+
+DEPENDENCIES = ["zigbee"]
+
+zigbee_ns = cg.esphome_ns.namespace("zigbee")
+ZigbeeTextSensor = zigbee_ns.class_("ZigbeeTextSensor", cg.Component)
+ZigBeeComponent = zigbee_ns.class_("ZigBeeComponent", cg.Component)
+
+TEXT_SENSORS = [CONF_CHANNEL_ENERGY, CONF_CHANNEL_MASK]
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ZigbeeTextSensor),
+        cv.GenerateID(CONF_ZIGBEE_ID): cv.use_id(ZigBeeComponent),
+        **{
+            cv.Optional(key): text_sensor.text_sensor_schema(
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in TEXT_SENSORS
+        },
+        cv.Optional(CONF_BUSIEST_ATTRIBUTES): text_sensor.text_sensor_schema(
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ).extend(
+            {
+                cv.Optional(CONF_COUNT, default=3): cv.int_range(1, 10),
+                cv.Optional(
+                    CONF_UPDATE_INTERVAL, default="60s"
+                ): cv.positive_time_period_milliseconds,
+            }
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    zb = await get_variable(config[CONF_ZIGBEE_ID])
+    var = cg.new_Pvariable(config[CONF_ID], zb)
+    await cg.register_component(var, config)
+    for key in TEXT_SENSORS:
+        if key in config:
+            sens = await text_sensor.new_text_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_text_sensor")(sens))
+    if busiest := config.get(CONF_BUSIEST_ATTRIBUTES):
+        cg.add_define("USE_ZIGBEE_ATTR_STATS")
+        sens = await text_sensor.new_text_sensor(busiest)
+        cg.add(
+            var.set_busiest_attributes_text_sensor(
+                sens,
+                busiest[CONF_COUNT],
+                busiest[CONF_UPDATE_INTERVAL].total_milliseconds,
+            )
+        )
@@ -0,0 +1,72 @@
+#include "zigbee_text_sensor.h"
+#include "esphome/core/log.h"
+#ifdef USE_ZIGBEE_ATTR_STATS
+#include <cinttypes>
+#include "../zigbee_attribute.h"
+#endif
+
+namespace esphome {
+namespace zigbee {
+
+void ZigbeeTextSensor::setup() {
+  this->zc_->add_on_energy_scan_callback([this]() { this->publish_energy_scan_(); });
+#ifdef USE_ZIGBEE_ATTR_STATS
+  if (this->busiest_attributes_text_sensor_ != nullptr) {
+    this->set_interval("busiest", this->busiest_interval_, [this]() { this->publish_busiest_attributes_(); });
+  }
+#endif
+}
+
+#ifdef USE_ZIGBEE_ATTR_STATS
+void ZigbeeTextSensor::publish_busiest_attributes_() {
+  // "1/0x0402/0x0000:120 1/0x0006/0x0000:14 ...", endpoint/cluster/attribute and the traffic since boot
+  std::string state;
+  char buf[32];
+  for (ZigBeeAttribute *attr : this->zc_->get_busiest_attributes(this->busiest_count_)) {
+    snprintf(buf, sizeof(buf), "%s%u/0x%04X/0x%04X:%" PRIu32, state.empty() ? "" : " ", attr->endpoint_id(),
+             attr->cluster_id(), attr->attr_id(), attr->get_stats().total());
+    state += buf;
+  }
+  this->busiest_attributes_text_sensor_->publish_state(state);
+}
+#endif
+
+void ZigbeeTextSensor::publish_energy_scan_() {
+  const int8_t *energy = this->zc_->get_channel_energy();
+  if (this->channel_energy_text_sensor_ != nullptr) {
+    // "11:-82 12:-90 ...", skipping channels that were not scanned
+    std::string state;
+    char buf[12];
+    for (uint8_t i = 0; i < 16; i++) {
+      if (energy[i] == INT8_MIN)
+        continue;
+      snprintf(buf, sizeof(buf), "%s%u:%d", state.empty() ? "" : " ", i + 11, energy[i]);
+      state += buf;
+    }
+    this->channel_energy_text_sensor_->publish_state(state);
+  }
+  if (this->channel_mask_text_sensor_ != nullptr) {
+    std::string state;
+    char buf[4];
+    uint32_t mask = this->zc_->get_preferred_channel_mask();
+    for (uint8_t channel = 11; channel <= 26; channel++) {
+      if (!(mask & (1 << channel)))
+        continue;
+      snprintf(buf, sizeof(buf), "%s%u", state.empty() ? "" : ",", channel);
+      state += buf;
+    }
+    this->channel_mask_text_sensor_->publish_state(state);
+  }
+}
+
+void ZigbeeTextSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "Zigbee Text Sensor:");
+  LOG_TEXT_SENSOR("  ", "Channel Energy", this->channel_energy_text_sensor_);
+  LOG_TEXT_SENSOR("  ", "Channel Mask", this->channel_mask_text_sensor_);
+#ifdef USE_ZIGBEE_ATTR_STATS
+  LOG_TEXT_SENSOR("  ", "Busiest Attributes", this->busiest_attributes_text_sensor_);
+#endif
+}
+
+}  // namespace zigbee
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "../zigbee.h"
+
+namespace esphome {
+namespace zigbee {
+
+class ZigbeeTextSensor : public Component {
+ public:
+  ZigbeeTextSensor(ZigBeeComponent *zc) : zc_(zc) {}
+  void setup() override;
+  void dump_config() override;
+
+  void set_channel_energy_text_sensor(text_sensor::TextSensor *sensor) { this->channel_energy_text_sensor_ = sensor; }
+  void set_channel_mask_text_sensor(text_sensor::TextSensor *sensor) { this->channel_mask_text_sensor_ = sensor; }
+#ifdef USE_ZIGBEE_ATTR_STATS
+  void set_busiest_attributes_text_sensor(text_sensor::TextSensor *sensor, uint8_t count, uint32_t interval) {
+    this->busiest_attributes_text_sensor_ = sensor;
+    this->busiest_count_ = count;
+    this->busiest_interval_ = interval;
+  }
+#endif
+
+ protected:
+  void publish_energy_scan_();
+#ifdef USE_ZIGBEE_ATTR_STATS
+  void publish_busiest_attributes_();
+#endif
+
+  ZigBeeComponent *zc_;
+  text_sensor::TextSensor *channel_energy_text_sensor_{nullptr};
+  text_sensor::TextSensor *channel_mask_text_sensor_{nullptr};
+#ifdef USE_ZIGBEE_ATTR_STATS
+  text_sensor::TextSensor *busiest_attributes_text_sensor_{nullptr};
+  uint8_t busiest_count_{3};
+  uint32_t busiest_interval_{60000};
+#endif
+};
+
+}  // namespace zigbee
+}  // namespace esphome
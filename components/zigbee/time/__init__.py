@@ -1,10 +1,17 @@
 import esphome.codegen as cg
 from esphome.components import time as time_
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_TIMEOUT
 from esphome.cpp_generator import get_variable
 
-from ..const import CONF_ZIGBEE_ID
+from ..const import (
+    CONF_MAX_RETRIES,
+    CONF_MAX_UPDATE_INTERVAL,
+    CONF_SERVER_ENDPOINT,
+    CONF_SOURCE,
+    CONF_SOURCE_ENDPOINT,
+    CONF_ZIGBEE_ID,
+)
 
 DEPENDENCIES = ["zigbee"]
 
@@ -15,6 +22,16 @@ CONFIG_SCHEMA = time_.TIME_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(ZigbeeTime),
         cv.GenerateID(CONF_ZIGBEE_ID): cv.use_id(ZigBeeComponent),
+        cv.Optional(CONF_TIMEOUT, default="5s"): cv.positive_not_null_time_period,
+        cv.Optional(CONF_MAX_RETRIES, default=5): cv.int_range(0, 255),
+        cv.Optional(
+            CONF_MAX_UPDATE_INTERVAL, default="4h"
+        ): cv.positive_not_null_time_period,
+        cv.Optional(CONF_SERVER_ENDPOINT): cv.int_range(1, 240),
+        cv.Optional(CONF_SOURCE, default="coordinator"): cv.one_of(
+            "coordinator", "parent", lower=True
+        ),
+        cv.Optional(CONF_SOURCE_ENDPOINT, default=1): cv.int_range(1, 240),
     }
 ).extend(cv.COMPONENT_SCHEMA)
 
@@ -25,3 +42,16 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID], zb)
     await cg.register_component(var, config)
     await time_.register_time(var, config)
+    cg.add(var.set_request_timeout(config[CONF_TIMEOUT].total_milliseconds))
+    cg.add(var.set_max_retries(config[CONF_MAX_RETRIES]))
+    cg.add(
+        var.set_max_update_interval(config[CONF_MAX_UPDATE_INTERVAL].total_milliseconds)
+    )
+    if CONF_SERVER_ENDPOINT in config:
+        cg.add(var.set_server_endpoint(config[CONF_SERVER_ENDPOINT]))
+        cg.add(zb.add_time_server(config[CONF_SERVER_ENDPOINT]))
+    cg.add(
+        var.set_source_parent(
+            config[CONF_SOURCE] == "parent", config[CONF_SOURCE_ENDPOINT]
+        )
+    )
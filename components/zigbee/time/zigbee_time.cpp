@@ -1,11 +1,14 @@
+#include <algorithm>
+#include <cstdlib>
 #include "zigbee_time.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
 namespace zigbee {
 
 void ZigbeeTime::send_timesync_request() {
-  ESP_LOGD(TAG, "Requesting time from coordinator...");
+  ESP_LOGD(TAG, "Requesting time from Zigbee network...");
   uint16_t attributes[] = {ESP_ZB_ZCL_ATTR_TIME_TIME_ID, ESP_ZB_ZCL_ATTR_TIME_TIME_STATUS_ID};
   esp_zb_zcl_read_attr_cmd_t read_req;
   read_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
@@ -16,14 +19,30 @@ void ZigbeeTime::send_timesync_request() {
   read_req.zcl_basic_cmd.src_endpoint = 1;
   read_req.zcl_basic_cmd.dst_addr_u.addr_short = 0x0000;  // coordinator
   if (esp_zb_lock_acquire(30 / portTICK_PERIOD_MS)) {
-    esp_zb_zcl_read_attr_cmd_req(&read_req);
+    // Ask the parent first, the last attempt always goes to the coordinator.
+    if (this->source_parent_ && this->retries_ < this->max_retries_) {
+      uint16_t parent = this->zc_->get_parent_address();
+      if (parent != 0xFFFF && parent != 0x0000) {
+        read_req.zcl_basic_cmd.dst_addr_u.addr_short = parent;
+        read_req.zcl_basic_cmd.dst_endpoint = this->source_endpoint_;
+      }
+    }
+    this->tsn_ = esp_zb_zcl_read_attr_cmd_req(&read_req);
     esp_zb_lock_release();
+    this->request_sent_ = millis();
     this->requested_ = true;
-    ESP_LOGD(TAG, "Sent request");
+    ESP_LOGD(TAG, "Sent request to 0x%04x (tsn %u, attempt %u)", read_req.zcl_basic_cmd.dst_addr_u.addr_short,
+             this->tsn_, this->retries_ + 1);
   }
 }
 
-void ZigbeeTime::recieve_timesync_response(esp_zb_zcl_read_attr_resp_variable_t *variable) {
+void ZigbeeTime::recieve_timesync_response(uint8_t tsn, esp_zb_zcl_read_attr_resp_variable_t *variable) {
+  if (!this->requested_ || tsn != this->tsn_) {
+    ESP_LOGD(TAG, "Ignoring time response with unexpected tsn %u", tsn);
+    return;
+  }
+  uint32_t rtt = millis() - this->request_sent_;
+  this->requested_ = false;
   uint32_t utc = 0;
   uint8_t sync_status = 0;
   while (variable != nullptr) {
@@ -46,10 +65,53 @@ void ZigbeeTime::recieve_timesync_response(esp_zb_zcl_read_attr_resp_variable_t
     }
     variable = variable->next;
   }
-  if ((utc != 0) && (sync_status & 0x3 != 0)) { /* 0x3 = either Master or Syncronized bits set */
+  if ((utc != 0) && ((sync_status & 0x3) != 0)) { /* 0x3 = either Master or Syncronized bits set */
+    // The coordinator sampled its clock somewhere between request and response, assume the middle.
+    this->last_rtt_ = rtt;
+    utc += (rtt / 2 + 500) / 1000;
+    int32_t offset = (int32_t) (utc - (uint32_t) ::time(nullptr));
+    ESP_LOGD(TAG, "Round trip time: %u ms, local clock offset: %d s", rtt, offset);
+    this->adapt_update_interval_(offset, utc);
     this->set_utc_time(utc);
   } else {
     ESP_LOGD(TAG, "Did not recieve both time and status; clock NOT updated");
+    this->schedule_retry_();
+  }
+}
+
+void ZigbeeTime::schedule_retry_() {
+  this->retries_++;
+  if (this->retries_ > this->max_retries_) {
+    ESP_LOGW(TAG, "Time sync failed after %u attempts, trying again in %u s", this->retries_,
+             this->get_update_interval() / 1000);
+    this->retries_ = 0;
+    this->next_request_ = millis() + this->get_update_interval();
+    return;
+  }
+  // exponential backoff: 2s, 4s, 8s, ... capped at one minute
+  uint32_t backoff = std::min<uint32_t>(1000u << std::min<uint8_t>(this->retries_, 6), 60000);
+  this->next_request_ = millis() + backoff;
+}
+
+void ZigbeeTime::adapt_update_interval_(int32_t offset, uint32_t utc) {
+  if (this->last_sync_utc_ == 0 || utc <= this->last_sync_utc_) {
+    return;
+  }
+  uint32_t elapsed = utc - this->last_sync_utc_;
+  this->drift_ppm_ = (float) offset * 1e6f / (float) elapsed;
+  uint32_t interval = this->get_update_interval();
+  if (std::abs(offset) <= 1) {
+    // Clock stayed within the one second resolution of the Time cluster, back off.
+    interval = interval > this->max_update_interval_ / 2 ? this->max_update_interval_ : interval * 2;
+  } else {
+    // Resync before the accumulated drift reaches one second.
+    interval = (uint32_t) std::min<uint64_t>((uint64_t) elapsed * 1000 / std::abs(offset), UINT32_MAX);
+  }
+  interval = std::max(this->min_update_interval_, std::min(interval, this->max_update_interval_));
+  if (interval != this->get_update_interval()) {
+    ESP_LOGD(TAG, "Drift %.1f ppm, next resync in %u s", this->drift_ppm_, interval / 1000);
+    this->set_update_interval(interval);
+    this->start_poller();
   }
 }
 
@@ -57,29 +119,76 @@ void ZigbeeTime::setup() {
   ESP_LOGD(TAG, "Using Zigbee network as time source");
   this->synced_ = false;
   this->requested_ = false;
+  this->min_update_interval_ = this->get_update_interval();
   this->zc_->zt_ = this;
 }
 
 void ZigbeeTime::update() {
   ESP_LOGD(TAG, "Updating time sync from Zigbee network...");
   this->synced_ = false;
+  this->retries_ = 0;
+  this->next_request_ = millis();
 }
 
 void ZigbeeTime::loop() {
+  if (this->requested_) {
+    if (millis() - this->request_sent_ >= this->timeout_) {
+      ESP_LOGD(TAG, "Time request (tsn %u) timed out", this->tsn_);
+      this->requested_ = false;
+      this->schedule_retry_();
+    }
+    return;
+  }
   if (this->synced_)
     return;
-  if (this->requested_)
+  if ((int32_t) (millis() - this->next_request_) < 0)
     return;
   if (zc_->is_connected()) {
     this->send_timesync_request();
   }
 }
 
+void ZigbeeTime::dump_config() {
+  ESP_LOGCONFIG(TAG, "Zigbee Time:");
+  ESP_LOGCONFIG(TAG, "  Timeout: %u ms, Max Retries: %u", this->timeout_, this->max_retries_);
+  ESP_LOGCONFIG(TAG, "  Resync Interval: %u s (min %u s, max %u s)", this->get_update_interval() / 1000,
+                this->min_update_interval_ / 1000, this->max_update_interval_ / 1000);
+  ESP_LOGCONFIG(TAG, "  Last Round Trip: %u ms, Drift: %.1f ppm", this->last_rtt_, this->drift_ppm_);
+  ESP_LOGCONFIG(TAG, "  Source: %s", this->source_parent_ ? "parent" : "coordinator");
+  if (this->server_endpoint_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Time Server Endpoint: %u", this->server_endpoint_);
+  }
+}
+
 void ZigbeeTime::set_utc_time(uint32_t utc) {
   this->synchronize_epoch_(utc);
+  this->last_sync_utc_ = utc;
+  this->last_sync_ = millis();
   this->synced_ = true;
   this->requested_ = false;
+  this->retries_ = 0;
+  if (this->server_endpoint_ != 0) {
+    this->update_time_server_();
+    this->set_interval("time_server", 1000, [this]() { this->update_time_server_(); });
+  }
+}
+
+void ZigbeeTime::update_time_server_() {
+  if (!this->zc_->is_connected()) {
+    return;
+  }
+  uint32_t zb_time = (uint32_t) ::time(nullptr) - zigbee_time_offset;
+  // Synchronized bit only, this device is not the time master. Drop it once the last sync is too old.
+  uint8_t status = (millis() - this->last_sync_) / 2 < this->max_update_interval_ ? 0x02 : 0x00;
+  // Never block the main loop for the server, a skipped second is corrected with the next update.
+  if (esp_zb_lock_acquire(0)) {
+    esp_zb_zcl_set_attribute_val(this->server_endpoint_, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_TIME_TIME_ID, &zb_time, false);
+    esp_zb_zcl_set_attribute_val(this->server_endpoint_, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_TIME_TIME_STATUS_ID, &status, false);
+    esp_zb_lock_release();
+  }
 }
 
 }  // namespace zigbee
-}  // namespace esphome
\ No newline at end of file
+}  // namespace esphome
@@ -18,14 +18,43 @@ class ZigbeeTime : public time::RealTimeClock {
   void setup() override;
   void loop() override;
   void update() override;
+  void dump_config() override;
   void set_utc_time(uint32_t utc);
   void send_timesync_request();
-  void recieve_timesync_response(esp_zb_zcl_read_attr_resp_variable_t *variable);
+  void recieve_timesync_response(uint8_t tsn, esp_zb_zcl_read_attr_resp_variable_t *variable);
+
+  void set_request_timeout(uint32_t timeout) { this->timeout_ = timeout; }
+  void set_max_retries(uint8_t max_retries) { this->max_retries_ = max_retries; }
+  void set_max_update_interval(uint32_t max_update_interval) { this->max_update_interval_ = max_update_interval; }
+  void set_server_endpoint(uint8_t endpoint) { this->server_endpoint_ = endpoint; }
+  void set_source_parent(bool source_parent, uint8_t endpoint) {
+    this->source_parent_ = source_parent;
+    this->source_endpoint_ = endpoint;
+  }
 
  protected:
+  void schedule_retry_();
+  void adapt_update_interval_(int32_t offset, uint32_t utc);
+  void update_time_server_();
+
   ZigBeeComponent *zc_;
   bool synced_;
   bool requested_;
+  uint8_t tsn_{0};
+  uint8_t retries_{0};
+  uint8_t max_retries_{5};
+  uint32_t timeout_{5000};
+  uint32_t request_sent_{0};  // millis() when the pending request was sent
+  uint32_t next_request_{0};  // millis() before which no new request is sent (backoff)
+  uint32_t last_rtt_{0};
+  uint32_t min_update_interval_{0};
+  uint32_t max_update_interval_{4 * 60 * 60 * 1000};
+  uint32_t last_sync_utc_{0};  // compensated UTC of the last successful sync, 0 if never synced
+  uint32_t last_sync_{0};      // millis() of the last successful sync
+  float drift_ppm_{0.0f};
+  uint8_t server_endpoint_{0};  // endpoint of the local Time cluster server, 0 if disabled
+  bool source_parent_{false};
+  uint8_t source_endpoint_{1};
 };
 
 }  // namespace zigbee
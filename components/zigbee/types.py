@@ -4,12 +4,19 @@ import esphome.codegen as cg
 zigbee_ns = cg.esphome_ns.namespace("zigbee")
 ZigBeeComponent = zigbee_ns.class_("ZigBeeComponent", cg.Component)
 ZigBeeAttribute = zigbee_ns.class_("ZigBeeAttribute", cg.Component)
+CoexPolicy = zigbee_ns.enum("CoexPolicy")
+ZBRxInfo = zigbee_ns.struct("ZBRxInfo")
 ZigBeeOnValueTrigger = zigbee_ns.class_(
     "ZigBeeOnValueTrigger", automation.Trigger.template(int), cg.Component
 )
 ZigBeeOnReportTrigger = zigbee_ns.class_(
     "ZigBeeOnReportTrigger", automation.Trigger.template(int), cg.Component
 )
+ZBCommand = zigbee_ns.struct("ZBCommand")
+ZigBeeOnCommandTrigger = zigbee_ns.class_(
+    "ZigBeeOnCommandTrigger",
+    automation.Trigger.template(ZBCommand.operator("const").operator("ref")),
+)
 ResetZigbeeAction = zigbee_ns.class_(
     "ResetZigbeeAction", automation.Action, cg.Parented.template(ZigBeeComponent)
 )
@@ -20,3 +27,52 @@ ReportAttrAction = zigbee_ns.class_(
 ReportAction = zigbee_ns.class_(
     "ReportAction", automation.Action, cg.Parented.template(ZigBeeComponent)
 )
+EnergyScanAction = zigbee_ns.class_(
+    "EnergyScanAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+ZBInjectEvent = zigbee_ns.enum("ZBInjectEvent")
+ZBInjectConfig = zigbee_ns.struct("ZBInjectConfig")
+InjectEventsAction = zigbee_ns.class_(
+    "InjectEventsAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+BenchmarkAction = zigbee_ns.class_(
+    "BenchmarkAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+AttributeStatsAction = zigbee_ns.class_(
+    "AttributeStatsAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+TraceDumpAction = zigbee_ns.class_(
+    "TraceDumpAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+TraceReplayAction = zigbee_ns.class_(
+    "TraceReplayAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+GroupAction = zigbee_ns.class_(
+    "GroupAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+ClientCommandAction = zigbee_ns.class_(
+    "ClientCommandAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+OnOffCommandAction = zigbee_ns.class_("OnOffCommandAction", ClientCommandAction)
+MoveToLevelCommandAction = zigbee_ns.class_(
+    "MoveToLevelCommandAction", ClientCommandAction
+)
+LevelMoveCommandAction = zigbee_ns.class_("LevelMoveCommandAction", ClientCommandAction)
+LevelStepCommandAction = zigbee_ns.class_("LevelStepCommandAction", ClientCommandAction)
+MoveToColorCommandAction = zigbee_ns.class_(
+    "MoveToColorCommandAction", ClientCommandAction
+)
+RecallSceneCommandAction = zigbee_ns.class_(
+    "RecallSceneCommandAction", ClientCommandAction
+)
+ZigBeeAttrResponseTrigger = zigbee_ns.class_(
+    "ZigBeeAttrResponseTrigger",
+    automation.Trigger.template(
+        cg.uint8, cg.global_ns.struct("esp_zb_zcl_attribute_t")
+    ),
+)
+RemoteAttrAction = zigbee_ns.class_(
+    "RemoteAttrAction", automation.Action, cg.Parented.template(ZigBeeComponent)
+)
+ReadAttrAction = zigbee_ns.class_("ReadAttrAction", RemoteAttrAction)
+WriteAttrAction = zigbee_ns.class_("WriteAttrAction", RemoteAttrAction)
@@ -1,6 +1,11 @@
 #include "zigbee.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cinttypes>
+#include <cstring>
 #include "esp_check.h"
 #include "nvs_flash.h"
 #include "zigbee_attribute.h"
@@ -9,6 +14,8 @@
 #include "zigbee_helpers.h"
 #ifdef CONFIG_WIFI_COEX
 #include "esp_coexist.h"
+#include "esp_ieee802154.h"
+#include "esp_wifi.h"
 #endif
 
 #ifdef CONFIG_PM_ENABLE
@@ -40,14 +47,7 @@ device_params_t coord;
  *
  */
 uint8_t *get_zcl_string(const char *str, uint8_t max_size, bool use_max_size) {
-  uint8_t str_len = static_cast<uint8_t>(strlen(str));
-  uint8_t zcl_str_size = use_max_size ? max_size : std::min(max_size, str_len);
-
-  uint8_t *zcl_str = new uint8_t[zcl_str_size + 1];  // string + length octet
-  zcl_str[0] = zcl_str_size;
-  memcpy(zcl_str + 1, str, str_len);
-
-  return zcl_str;
+  return get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, strlen(str), max_size, use_max_size);
 }
 
 static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask) {
@@ -82,11 +82,15 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
       if (err_status == ESP_OK) {
         ESP_LOGD(TAG, "Device started up in %sfactory-reset mode", esp_zb_bdb_is_factory_new() ? "" : "non ");
         global_zigbee->started_ = true;
-        if (esp_zb_bdb_is_factory_new()) {
+        if (esp_zb_bdb_is_factory_new() && global_zigbee->energy_scan_on_boot_) {
+          ESP_LOGD(TAG, "Scan channel energy before network steering");
+          global_zigbee->request_energy_scan(true);
+        } else if (esp_zb_bdb_is_factory_new()) {
           ESP_LOGD(TAG, "Start network steering");
           esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
         } else {
           ESP_LOGD(TAG, "Device rebooted");
+          global_zigbee->apply_groups();
           global_zigbee->searchBindings();
         }
       } else {
@@ -110,6 +114,7 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                  extended_pan_id[2], extended_pan_id[1], extended_pan_id[0], esp_zb_get_pan_id(),
                  esp_zb_get_current_channel());
         global_zigbee->joined_ = true;
+        global_zigbee->apply_groups();
         global_zigbee->enable_loop_soon_any_context();
       } else {
         ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
@@ -123,7 +128,14 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
         }
       }
       break;
+    case ESP_ZB_ZDO_SIGNAL_DEVICE_ANNCE:
+    case ESP_ZB_ZDO_SIGNAL_LEAVE_INDICATION:
+      // short addresses may now belong to another device
+      ESP_LOGD(TAG, "ZDO signal: %s (0x%x)", esp_zb_zdo_signal_to_string(sig_type), sig_type);
+      global_zigbee->invalidate_ieee_addresses();
+      break;
     case ESP_ZB_ZDO_SIGNAL_LEAVE:
+      global_zigbee->invalidate_ieee_addresses();
       leave_params = (esp_zb_zdo_signal_leave_params_t *) esp_zb_app_signal_get_params(p_sg_p);
       if (leave_params->leave_type == ESP_ZB_NWK_LEAVE_TYPE_RESET) {
         ESP_LOGD(TAG, "Reset device");
@@ -145,19 +157,275 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
   }
 }
 
+static void energy_detect_cb(esp_zb_zdp_status_t status, uint16_t count,
+                             esp_zb_energy_detect_channel_info_t *channel_info) {
+  if (status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+    ESP_LOGW(TAG, "Energy scan failed (status: %d)", status);
+    count = 0;
+  }
+  global_zigbee->on_energy_scan(count, channel_info);
+}
+
+#ifdef CONFIG_WIFI_COEX
+// 802.15.4 channels are 2 MHz wide at 2405 + 5 * (ch - 11) MHz, WiFi channels 20 MHz wide at 2407 + 5 * ch MHz
+static bool overlaps_wifi_channel(uint8_t zb_channel, uint8_t wifi_channel) {
+  int zb_freq = 2405 + 5 * (zb_channel - 11);
+  int wifi_freq = wifi_channel == 14 ? 2484 : 2407 + 5 * wifi_channel;
+  return std::abs(zb_freq - wifi_freq) <= 11;
+}
+#endif
+
+// Must be called from the Zigbee task or with the Zigbee lock held
+void ZigBeeComponent::request_energy_scan(bool steer) {
+  this->energy_scan_steer_ = steer;
+  esp_zb_zdo_energy_detect_request(ESP_ZB_PRIMARY_CHANNEL_MASK, this->energy_scan_duration_, energy_detect_cb);
+}
+
+void ZigBeeComponent::start_energy_scan() {
+  if (!this->started_) {
+    ESP_LOGW(TAG, "Zigbee stack not started, energy scan skipped");
+    return;
+  }
+  if (this->try_lock()) {
+    this->request_energy_scan(false);
+    esp_zb_lock_release();
+  }
+}
+
+// Runs in the Zigbee task
+void ZigBeeComponent::on_energy_scan(uint16_t count, esp_zb_energy_detect_channel_info_t *channel_info) {
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t channel = channel_info[i].channel_number;
+    if (channel >= 11 && channel <= 26) {
+      this->channel_energy_[channel - 11] = channel_info[i].energy_detected;
+    }
+  }
+  uint8_t wifi_channel = 0;
+#ifdef CONFIG_WIFI_COEX
+  wifi_second_chan_t second;
+  if (esp_wifi_get_channel(&wifi_channel, &second) != ESP_OK) {
+    wifi_channel = 0;
+  }
+#endif
+  // Pick the quietest scanned channels, skipping the ones overlapping the active WiFi channel
+  uint8_t order[16];
+  for (uint8_t i = 0; i < 16; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order, order + 16, [this](uint8_t a, uint8_t b) {
+    return this->channel_energy_[a] < this->channel_energy_[b];
+  });
+  uint32_t mask = 0;
+  uint8_t selected = 0;
+  for (uint8_t i = 0; i < 16 && selected < this->preferred_channels_; i++) {
+    uint8_t channel = order[i] + 11;
+    if (this->channel_energy_[order[i]] == INT8_MIN || !(ESP_ZB_PRIMARY_CHANNEL_MASK & (1 << channel))) {
+      continue;
+    }
+#ifdef CONFIG_WIFI_COEX
+    if (wifi_channel != 0 && overlaps_wifi_channel(channel, wifi_channel)) {
+      continue;
+    }
+#endif
+    mask |= 1 << channel;
+    selected++;
+  }
+  if (mask != 0) {
+    this->preferred_channel_mask_ = mask;
+    // Steering tries the primary set first and falls back to the secondary set
+    esp_zb_set_primary_network_channel_set(mask);
+    esp_zb_set_secondary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK & ~mask);
+  }
+  this->energy_scan_updated_ = true;
+  this->enable_loop_soon_any_context();
+  if (this->energy_scan_steer_) {
+    this->energy_scan_steer_ = false;
+    ESP_LOGD(TAG, "Start network steering");
+    esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+  }
+}
+
+// Runs in the Zigbee task, the buffer holds zdo_diagnostics_full_stats_t
+static void tx_stats_cb(zb_bufid_t bufid) {
+  zdo_diagnostics_full_stats_t *full_stats = (zdo_diagnostics_full_stats_t *) zb_buf_begin(bufid);
+  if (full_stats->status == RET_OK) {
+    global_zigbee->on_tx_stats(TxStats{
+        .tx_total = full_stats->mac_stats.mac_tx_ucast_total,
+        .tx_failures = full_stats->mac_stats.mac_tx_ucast_failures,
+        .tx_retries = full_stats->mac_stats.mac_tx_ucast_retries,
+        .cca_failures = full_stats->mac_stats.phy_cca_fail_count,
+        .drops =
+            (uint32_t) full_stats->mac_stats.phy_to_mac_que_lim_reached + full_stats->mac_stats.mac_validate_drop_cnt,
+        .coex_boosts = 0,
+    });
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+    global_zigbee->update_diagnostics(*full_stats);
+#endif
+  }
+  zb_buf_free(bufid);
+}
+
+// Runs in the Zigbee task, add and remove confirmations share the layout
+static void group_conf_cb(zb_bufid_t bufid) {
+  zb_apsme_add_group_conf_t *conf = ZB_BUF_GET_PARAM(bufid, zb_apsme_add_group_conf_t);
+  if (conf->status != RET_OK) {
+    ZB_DEFER_LOGW(ZB_LOG_GROUP_STATUS, conf->group_address, conf->endpoint, conf->status);
+  }
+  zb_buf_free(bufid);
+}
+
+// Runs in the Zigbee task or with the Zigbee lock held
+static bool request_group_change(bool add, uint8_t endpoint_id, uint16_t group) {
+  zb_bufid_t bufid = zb_buf_get_out();
+  if (bufid == ZB_BUF_INVALID) {
+    return false;
+  }
+  if (add) {
+    zb_apsme_add_group_req_t *req = ZB_BUF_GET_PARAM(bufid, zb_apsme_add_group_req_t);
+    req->group_address = group;
+    req->endpoint = endpoint_id;
+    req->confirm_cb = group_conf_cb;
+    zb_apsme_add_group_request(bufid);
+  } else {
+    zb_apsme_remove_group_req_t *req = ZB_BUF_GET_PARAM(bufid, zb_apsme_remove_group_req_t);
+    req->group_address = group;
+    req->endpoint = endpoint_id;
+    req->confirm_cb = group_conf_cb;
+    zb_apsme_remove_group_request(bufid);
+  }
+  return true;
+}
+
+void ZigBeeComponent::add_missing_cluster_(uint8_t endpoint_id, uint16_t cluster_id) {
+  auto ep = this->endpoint_list_.find(endpoint_id);
+  if (ep != this->endpoint_list_.end() &&
+      esp_zb_cluster_list_get_cluster(std::get<1>(ep->second), cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE) != nullptr) {
+    return;
+  }
+  if (this->attribute_list_.count({endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE}) == 0) {
+    this->add_cluster(endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+  }
+}
+
+void ZigBeeComponent::apply_groups() {
+  for (auto &[endpoint_id, group] : this->groups_) {
+    if (!zb_aps_is_endpoint_in_group(group, endpoint_id)) {
+      ESP_LOGD(TAG, "Add endpoint %u to group 0x%04x", endpoint_id, group);
+      request_group_change(true, endpoint_id, group);
+    }
+  }
+}
+
+bool ZigBeeComponent::add_group(uint8_t endpoint_id, uint16_t group) {
+  if (!this->started_) {
+    this->add_group_membership(endpoint_id, group);
+    return true;
+  }
+  if (!this->try_lock()) {
+    ESP_LOGW(TAG, "Zigbee stack busy, endpoint %u not added to group 0x%04x", endpoint_id, group);
+    return false;
+  }
+  bool ret = request_group_change(true, endpoint_id, group);
+  esp_zb_lock_release();
+  return ret;
+}
+
+bool ZigBeeComponent::remove_group(uint8_t endpoint_id, uint16_t group) {
+  if (!this->started_) {
+    auto membership = std::make_pair(endpoint_id, group);
+    this->groups_.erase(std::remove(this->groups_.begin(), this->groups_.end(), membership), this->groups_.end());
+    return true;
+  }
+  if (!this->try_lock()) {
+    ESP_LOGW(TAG, "Zigbee stack busy, endpoint %u not removed from group 0x%04x", endpoint_id, group);
+    return false;
+  }
+  bool ret = request_group_change(false, endpoint_id, group);
+  esp_zb_lock_release();
+  return ret;
+}
+
+bool ZigBeeComponent::is_group_member(uint8_t endpoint_id, uint16_t group) {
+  if (!this->started_ || !this->try_lock()) {
+    return false;
+  }
+  bool member = zb_aps_is_endpoint_in_group(group, endpoint_id);
+  esp_zb_lock_release();
+  return member;
+}
+
+// Only requested statistics are passed to the tx stats callbacks, internal polls update the counters silently
+void ZigBeeComponent::request_tx_stats() {
+  if (this->poll_tx_stats_()) {
+    this->tx_stats_publish_ = true;
+  }
+}
+
+bool ZigBeeComponent::poll_tx_stats_() {
+  if (!this->started_ || !this->try_lock()) {
+    return false;
+  }
+  zdo_diagnostics_get_stats(tx_stats_cb, ZB_PIB_ATTRIBUTE_IEEE_DIAGNOSTIC_INFO);
+  esp_zb_lock_release();
+  return true;
+}
+
+// Runs in the Zigbee task
+void ZigBeeComponent::on_tx_stats(const TxStats &stats) {
+  portENTER_CRITICAL(&this->tx_stats_lock_);
+  this->tx_stats_ = stats;
+  portEXIT_CRITICAL(&this->tx_stats_lock_);
+  this->tx_stats_updated_ = true;
+  this->enable_loop_soon_any_context();
+}
+
+#ifdef CONFIG_WIFI_COEX
+void ZigBeeComponent::set_coex_zigbee_priority_(bool high) {
+  esp_ieee802154_coex_config_t config;
+  if (high) {
+    config = {.idle = IEEE802154_LOW, .txrx = IEEE802154_HIGH, .txrx_at = IEEE802154_HIGH};
+  } else if (this->coex_policy_ == COEX_POLICY_WIFI) {
+    config = {.idle = IEEE802154_IDLE, .txrx = IEEE802154_LOW, .txrx_at = IEEE802154_LOW};
+  } else {
+    config = {.idle = IEEE802154_IDLE, .txrx = IEEE802154_LOW, .txrx_at = IEEE802154_MIDDLE};
+  }
+  esp_ieee802154_set_coex_config(config);
+}
+
+void ZigBeeComponent::setup_coex_() {
+  switch (this->coex_policy_) {
+    case COEX_POLICY_ZIGBEE:
+      this->set_coex_zigbee_priority_(true);
+      break;
+    case COEX_POLICY_ZIGBEE_WINDOW:
+      this->set_interval("coex", this->coex_period_, [this]() {
+        this->set_coex_zigbee_priority_(true);
+        this->set_timeout("coex_window", this->coex_window_, [this]() { this->set_coex_zigbee_priority_(false); });
+      });
+      break;
+    case COEX_POLICY_WIFI:
+      this->set_coex_zigbee_priority_(false);
+      // Zigbee starves at most one period, failed transmissions then get a priority window
+      this->set_interval("coex", this->coex_period_, [this]() { this->poll_tx_stats_(); });
+      break;
+    default:
+      break;
+  }
+}
+#endif
+
 // Recall bounded devices from the binding table after reboot
 void ZigBeeComponent::bindingTableCb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx) {
   bool done = true;
   esp_zb_zdo_mgmt_bind_param_t *req = (esp_zb_zdo_mgmt_bind_param_t *) user_ctx;
   esp_zb_zdp_status_t zdo_status = (esp_zb_zdp_status_t) table_info->status;
-  ESP_LOGD(TAG, "Binding table callback for address 0x%04x with status %d", req->dst_addr, zdo_status);
+  ZB_DEFER_LOGD(ZB_LOG_BINDING_STATUS, req->dst_addr, zdo_status);
   if (zdo_status == ESP_ZB_ZDP_STATUS_SUCCESS) {
     // Print binding table log simple
-    ESP_LOGD(TAG, "Binding table info: total %d, index %d, count %d", table_info->total, table_info->index,
-             table_info->count);
+    ZB_DEFER_LOGD(ZB_LOG_BINDING_INFO, table_info->total, table_info->index, table_info->count);
 
     if (table_info->total == 0) {
-      ESP_LOGD(TAG, "No binding table entries found");
+      ZB_DEFER_LOGD(ZB_LOG_BINDING_EMPTY);
       free(req);
       global_zigbee->connected_ = true;
       return;
@@ -165,8 +433,8 @@ void ZigBeeComponent::bindingTableCb(const esp_zb_zdo_binding_table_info_t *tabl
 
     esp_zb_zdo_binding_table_record_t *record = table_info->record;
     for (int i = 0; i < table_info->count; i++) {
-      ESP_LOGD(TAG, "Binding table record: src_endp %d, dst_endp %d, cluster_id 0x%04x, dst_addr_mode %d",
-               record->src_endp, record->dst_endp, record->cluster_id, record->dst_addr_mode);
+      ZB_DEFER_LOGD(ZB_LOG_BINDING_RECORD, record->src_endp, record->dst_endp, record->cluster_id,
+                    record->dst_addr_mode);
 
       zb_device_params_t *device = (zb_device_params_t *) calloc(1, sizeof(zb_device_params_t));
       device->endpoint = record->dst_endp;
@@ -176,12 +444,11 @@ void ZigBeeComponent::bindingTableCb(const esp_zb_zdo_binding_table_info_t *tabl
       } else {  // ESP_ZB_APS_ADDR_MODE_64_ENDP_PRESENT
         memcpy(device->ieee_addr, record->dst_address.addr_long, sizeof(esp_zb_ieee_addr_t));
       }
-      ESP_LOGD(TAG,
-               "Device bound to EP %d -> device endpoint: %d, short addr: 0x%04x, ieee addr: "
-               "%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X",
-               record->src_endp, device->endpoint, device->short_addr, device->ieee_addr[7], device->ieee_addr[6],
-               device->ieee_addr[5], device->ieee_addr[4], device->ieee_addr[3], device->ieee_addr[2],
-               device->ieee_addr[1], device->ieee_addr[0]);
+      ZB_DEFER_LOGD(ZB_LOG_BINDING_DEVICE, record->src_endp, device->endpoint, device->short_addr,
+                    encode_uint32(device->ieee_addr[7], device->ieee_addr[6], device->ieee_addr[5],
+                                  device->ieee_addr[4]),
+                    encode_uint32(device->ieee_addr[3], device->ieee_addr[2], device->ieee_addr[1],
+                                  device->ieee_addr[0]));
       record = record->next;
     }
 
@@ -196,7 +463,7 @@ void ZigBeeComponent::bindingTableCb(const esp_zb_zdo_binding_table_info_t *tabl
 
   if (done) {
     // Print bound devices
-    ESP_LOGD(TAG, "Filling bounded devices finished");
+    ZB_DEFER_LOGD(ZB_LOG_BINDING_DONE);
     free(req);
     global_zigbee->connected_ = true;
   }
@@ -223,6 +490,55 @@ void load_zb_event(ZBEvent *event, esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_a
   event->load_read_attr_resp_event(info, variables);
 }
 
+void load_zb_event(ZBEvent *event, const esp_zb_zcl_custom_cluster_command_message_t *message) {
+  event->load_custom_cmd_event(message);
+}
+
+void load_zb_event(ZBEvent *event, const esp_zb_zcl_cmd_default_resp_message_t *message) {
+  event->load_default_resp_event(message);
+}
+
+void load_zb_event(ZBEvent *event, const esp_zb_zcl_cmd_write_attr_resp_message_t *message) {
+  event->load_write_attr_resp_event(message);
+}
+
+void load_zb_event(ZBEvent *event, uint8_t endpoint, const uint8_t *scene_data, uint8_t size) {
+  event->load_scene_recall_event(endpoint, scene_data, size);
+}
+
+// Link quality of the last frame from the source, only valid in the Zigbee task
+static ZBRxInfo get_rx_info(const esp_zb_zcl_addr_t *src_address) {
+  ZBRxInfo rx{millis(), 0, ZB_RX_RSSI_UNKNOWN};
+  if (src_address != nullptr && src_address->addr_type == ESP_ZB_ZCL_ADDR_TYPE_SHORT) {
+    zb_uint8_t lqi;
+    zb_int8_t rssi;
+    if (zb_zdo_get_diag_data(src_address->u.short_addr, &lqi, &rssi)) {
+      rx.lqi = lqi;
+      rx.rssi = rssi;
+    }
+  }
+  return rx;
+}
+
+// The set attribute callback does not pass the source of the write
+static ZBRxInfo get_rx_info(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute,
+                            uint8_t *current_level) {
+  return get_rx_info(nullptr);
+}
+
+static ZBRxInfo get_rx_info(const esp_zb_zcl_report_attr_message_t *message) {
+  return get_rx_info(&message->src_address);
+}
+
+static ZBRxInfo get_rx_info(esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_attr_resp_variable_t *variables) {
+  return get_rx_info(&info.src_address);
+}
+
+// Scene recalls are applied in the Zigbee task, the command source is not passed
+static ZBRxInfo get_rx_info(uint8_t endpoint, const uint8_t *scene_data, uint8_t size) { return get_rx_info(nullptr); }
+
+template<typename T> static ZBRxInfo get_rx_info(const T *message) { return get_rx_info(&message->info.src_address); }
+
 template<typename... Args> void enqueue_zb_event(Args... args) {
   // Allocate an event from the pool
   ZBEvent *event = global_zigbee->zb_event_pool_.allocate();
@@ -234,6 +550,10 @@ template<typename... Args> void enqueue_zb_event(Args... args) {
 
   // Load new event data (replaces previous event)
   load_zb_event(event, args...);
+  event->rx_ = get_rx_info(args...);
+#if defined(USE_ZIGBEE_BENCHMARK) || defined(USE_ZIGBEE_TRACE) || defined(USE_ZIGBEE_FAST_PATH)
+  event->queued_ = micros();
+#endif
 
   // Push the event to the queue
   global_zigbee->zb_events_.push(event);
@@ -247,27 +567,34 @@ template void enqueue_zb_event(esp_zb_device_cb_common_info_t info, esp_zb_zcl_a
                                uint8_t *current_level);
 template void enqueue_zb_event(const esp_zb_zcl_report_attr_message_t *message);
 template void enqueue_zb_event(esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_attr_resp_variable_t *variables);
+template void enqueue_zb_event(const esp_zb_zcl_custom_cluster_command_message_t *message);
+template void enqueue_zb_event(const esp_zb_zcl_cmd_default_resp_message_t *message);
+template void enqueue_zb_event(const esp_zb_zcl_cmd_write_attr_resp_message_t *message);
+template void enqueue_zb_event(uint8_t endpoint, const uint8_t *scene_data, uint8_t size);
 
 static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t *message) {
   ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
   ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG,
                       "Received message: error status(%d)", message->info.status);
-  ESP_LOGD(TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)",
-           message->info.dst_endpoint, message->info.cluster, message->attribute.id, message->attribute.data.size);
+#ifdef USE_ZIGBEE_FAST_PATH
+  global_zigbee->apply_fast_output(message->info.dst_endpoint, message->info.cluster, message->attribute, micros());
+#endif
+  ZB_DEFER_LOGD(ZB_LOG_SET_ATTR, message->info.dst_endpoint, message->info.cluster, message->attribute.id,
+                message->attribute.data.size);
 
   // if the attribute is On/Off and it is set to Off, restore the previous level
   esp_zb_zcl_attr_t *current_level = nullptr;
   if (message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF) {
     if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID &&
         message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL && !*(bool *) message->attribute.data.value) {
-      ESP_LOGD(TAG, "turned off");
+      ZB_DEFER_LOGD(ZB_LOG_TURNED_OFF);
       if (esp_zb_zcl_get_cluster(message->info.dst_endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
                                  ESP_ZB_ZCL_CLUSTER_SERVER_ROLE) != nullptr) {
         current_level =
             esp_zb_zcl_get_attribute(message->info.dst_endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
                                      ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID);
         if (current_level) {
-          ESP_LOGD(TAG, "got level");
+          ZB_DEFER_LOGD(ZB_LOG_GOT_LEVEL);
           esp_zb_zcl_set_attribute_val(message->info.dst_endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
                                        current_level->data_p, false);
@@ -285,8 +612,11 @@ static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t
 
 static esp_err_t zb_cmd_attribute_handler(const esp_zb_zcl_cmd_read_attr_resp_message_t *message) {
   ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
-  ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG,
-                      "Received message: error status(%d)", message->info.status);
+  if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+    // pass it on so a pending read request fails with the reported status instead of timing out
+    enqueue_zb_event(message->info, (esp_zb_zcl_read_attr_resp_variable_t *) nullptr);
+    return ESP_OK;
+  }
   enqueue_zb_event(message->info, message->variables);
   return ESP_OK;
 }
@@ -299,8 +629,48 @@ static esp_err_t zb_report_attribute_handler(const esp_zb_zcl_report_attr_messag
   return ESP_OK;
 }
 
-static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message) {
+#ifdef USE_ZIGBEE_TRACE
+// Attribute callbacks with success status, as passed to the handlers
+static void trace_zb_action(esp_zb_core_action_callback_id_t callback_id, const void *message) {
+  switch (callback_id) {
+    case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID: {
+      auto *msg = (const esp_zb_zcl_set_attr_value_message_t *) message;
+      if (msg->info.status == ESP_ZB_ZCL_STATUS_SUCCESS) {
+        global_zigbee->record_trace(INJECT_SET_ATTR, msg->info.dst_endpoint, msg->info.cluster, msg->attribute);
+      }
+      break;
+    }
+    case ESP_ZB_CORE_REPORT_ATTR_CB_ID: {
+      auto *msg = (const esp_zb_zcl_report_attr_message_t *) message;
+      if (msg->status == ESP_ZB_ZCL_STATUS_SUCCESS) {
+        global_zigbee->record_trace(INJECT_REPORT_ATTR, msg->dst_endpoint, msg->cluster, msg->attribute);
+      }
+      break;
+    }
+    case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID: {
+      auto *msg = (const esp_zb_zcl_cmd_read_attr_resp_message_t *) message;
+      if (msg->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        break;
+      }
+      // one record per attribute, replayed as separate responses
+      for (auto *var = msg->variables; var != nullptr; var = var->next) {
+        global_zigbee->record_trace(INJECT_READ_RESP, msg->info.dst_endpoint, msg->info.cluster, var->attribute);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+#endif
+
+esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message) {
   esp_err_t ret = ESP_OK;
+#ifdef USE_ZIGBEE_TRACE
+  if (message != nullptr) {
+    trace_zb_action(callback_id, message);
+  }
+#endif
   switch (callback_id) {
     case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
       ret = zb_attribute_handler((esp_zb_zcl_set_attr_value_message_t *) message);
@@ -311,22 +681,886 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     case ESP_ZB_CORE_REPORT_ATTR_CB_ID:
       ret = zb_report_attribute_handler((esp_zb_zcl_report_attr_message_t *) message);
       break;
+    case ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID:
+      enqueue_zb_event((esp_zb_zcl_cmd_write_attr_resp_message_t *) message);
+      break;
     case ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID:
-      ESP_LOGD(TAG, "Receive Zigbee default response callback");
+      ZB_DEFER_LOGD(ZB_LOG_DEFAULT_RESP);
+      enqueue_zb_event((esp_zb_zcl_cmd_default_resp_message_t *) message);
+      break;
+    case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+    case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_RESP_CB_ID:
+      ret = global_zigbee->on_custom_command((esp_zb_zcl_custom_cluster_command_message_t *) message);
+      break;
+    case ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID:
+      ret = global_zigbee->on_store_scene((esp_zb_zcl_store_scene_message_t *) message);
       break;
+    case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+      ret = global_zigbee->on_recall_scene((esp_zb_zcl_recall_scene_message_t *) message);
+      break;
+#ifdef USE_ZIGBEE_OTA
+    case ESP_ZB_CORE_OTA_UPGRADE_QUERY_IMAGE_RESP_CB_ID:
+      ret = global_zigbee->on_ota_query_response((esp_zb_zcl_ota_upgrade_query_image_resp_message_t *) message);
+      break;
+    case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+      ret = global_zigbee->on_ota_upgrade((esp_zb_zcl_ota_upgrade_value_message_t *) message);
+      break;
+#endif
     default:
-      ESP_LOGW(TAG, "Receive Zigbee action(0x%x) callback", callback_id);
+      ZB_DEFER_LOGW(ZB_LOG_UNHANDLED_ACTION, callback_id);
       break;
   }
   return ret;
 }
 
+// Runs in the Zigbee task, commands with a synchronous handler were answered by on_raw_custom_command()
+esp_err_t ZigBeeComponent::on_custom_command(const esp_zb_zcl_custom_cluster_command_message_t *message) {
+  ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+  const esp_zb_zcl_cmd_info_t &info = message->info;
+  if (this->command_handlers_.find({info.dst_endpoint, info.cluster, info.command.id}) ==
+      this->command_handlers_.end()) {
+    ZB_DEFER_LOGD(ZB_LOG_NO_CMD_HANDLER, info.command.id, info.dst_endpoint, info.cluster);
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  if (message->data.size > MAX_ZB_CMD_PAYLOAD) {
+    ZB_DEFER_LOGW(ZB_LOG_CMD_TOO_LARGE, info.command.id, message->data.size);
+    return ESP_ERR_INVALID_SIZE;
+  }
+  enqueue_zb_event(message);
+  return ESP_OK;
+}
+
+// Runs in the Zigbee task before the stack handles the command. Synchronous handlers are called on the raw frame, so
+// the response command carries the payload bytes as they are and the default response the ZCL status of the handler.
+// The action callback of the stack could only report a generic failure. Returns false if the stack should go on.
+bool ZigBeeComponent::on_raw_custom_command(uint8_t bufid) {
+  zb_zcl_parsed_hdr_t cmd_info;
+  ZB_ZCL_COPY_PARSED_HEADER(bufid, &cmd_info);
+  const auto &addr = ZB_ZCL_PARSED_HDR_SHORT_DATA(&cmd_info);
+  std::tuple<uint8_t, uint16_t, uint8_t> key{addr.dst_endpoint, cmd_info.cluster_id, cmd_info.cmd_id};
+  auto sync_handler = this->sync_command_handlers_.find(key);
+  uint16_t size = zb_buf_len(bufid);
+  if (sync_handler == this->sync_command_handlers_.end() || size > MAX_ZB_CMD_PAYLOAD) {
+    return false;  // on_custom_command() passes it to the main loop or rejects it
+  }
+  esp_zb_zcl_custom_cluster_command_message_t message{};
+  message.info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+  message.info.header.tsn = cmd_info.seq_number;
+  message.info.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+  message.info.src_address.u.short_addr = addr.source.u.short_addr;
+  message.info.dst_address = addr.dst_addr;
+  message.info.src_endpoint = addr.src_endpoint;
+  message.info.dst_endpoint = addr.dst_endpoint;
+  message.info.cluster = cmd_info.cluster_id;
+  message.info.profile = cmd_info.profile_id;
+  message.info.command.id = cmd_info.cmd_id;
+  message.info.command.direction = cmd_info.cmd_direction;
+  message.data.size = size;
+  message.data.value = zb_buf_begin(bufid);
+  ZBCommand command{
+      .endpoint = addr.dst_endpoint,
+      .cluster = cmd_info.cluster_id,
+      .command = cmd_info.cmd_id,
+      .tsn = cmd_info.seq_number,
+      .src_address = message.info.src_address,
+      .src_endpoint = addr.src_endpoint,
+      .data = (const uint8_t *) message.data.value,
+      .size = (uint8_t) size,
+      .rx = get_rx_info(&message.info.src_address),
+  };
+  ZBCommandResponse response{};
+  uint8_t status = sync_handler->second(command, &response);
+  if (this->command_handlers_.find(key) != this->command_handlers_.end()) {
+    enqueue_zb_event(&message);  // copies the payload before the buffer is reused
+  }
+  if (status != ZB_ZCL_STATUS_SUCCESS || !response.send) {
+    // sent unless the sender disabled it for successful commands, frees the buffer otherwise
+    zb_zcl_send_default_handler(bufid, &cmd_info, (zb_zcl_status_t) status);
+    return true;
+  }
+  zb_uint8_t direction = cmd_info.cmd_direction == ZB_ZCL_FRAME_DIRECTION_TO_SRV ? ZB_ZCL_FRAME_DIRECTION_TO_CLI
+                                                                                 : ZB_ZCL_FRAME_DIRECTION_TO_SRV;
+  zb_uint8_t *ptr = (zb_uint8_t *) ZB_ZCL_START_PACKET(bufid);
+  ZB_ZCL_CONSTRUCT_SPECIFIC_COMMAND_RES_FRAME_CONTROL_A(ptr, direction, cmd_info.is_manuf_specific);
+  ZB_ZCL_CONSTRUCT_COMMAND_HEADER_EXT(ptr, cmd_info.seq_number, cmd_info.is_manuf_specific, cmd_info.manuf_specific,
+                                      response.command);
+  ZB_ZCL_PACKET_PUT_DATA_N(ptr, response.data, response.size);
+  ZB_ZCL_FINISH_PACKET(bufid, ptr)
+  ZB_ZCL_SEND_COMMAND_SHORT(bufid, addr.source.u.short_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, addr.src_endpoint,
+                            addr.dst_endpoint, cmd_info.profile_id, cmd_info.cluster_id, NULL);
+  return true;
+}
+
+void ZigBeeComponent::handle_custom_command(esp_zb_zcl_cmd_info_t info, const uint8_t *data, uint8_t size,
+                                            const ZBRxInfo &rx) {
+  auto handlers = this->command_handlers_.find({info.dst_endpoint, info.cluster, info.command.id});
+  if (handlers == this->command_handlers_.end()) {
+    return;
+  }
+  ZBCommand command{
+      .endpoint = info.dst_endpoint,
+      .cluster = info.cluster,
+      .command = info.command.id,
+      .tsn = info.header.tsn,
+      .src_address = info.src_address,
+      .src_endpoint = info.src_endpoint,
+      .data = data,
+      .size = size,
+      .rx = rx,
+  };
+  for (auto &handler : handlers->second) {
+    handler(command);
+  }
+}
+
+bool ZigBeeComponent::send_on_off(const ZBTarget &target, uint8_t command) {
+  esp_zb_zcl_on_off_cmd_t cmd_req{};
+  cmd_req.on_off_cmd_id = command;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, command, &cmd_req, esp_zb_zcl_on_off_cmd_req);
+}
+
+bool ZigBeeComponent::send_move_to_level(const ZBTarget &target, uint8_t level, uint16_t transition_time) {
+  esp_zb_zcl_move_to_level_cmd_t cmd_req{};
+  cmd_req.level = level;
+  cmd_req.transition_time = transition_time;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                ESP_ZB_ZCL_CMD_LEVEL_CONTROL_MOVE_TO_LEVEL_WITH_ON_OFF, &cmd_req,
+                                esp_zb_zcl_level_move_to_level_with_onoff_cmd_req);
+}
+
+bool ZigBeeComponent::send_level_move(const ZBTarget &target, uint8_t mode, uint8_t rate) {
+  esp_zb_zcl_level_move_cmd_t cmd_req{};
+  cmd_req.move_mode = mode;
+  cmd_req.rate = rate;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                ESP_ZB_ZCL_CMD_LEVEL_CONTROL_MOVE_WITH_ON_OFF, &cmd_req,
+                                esp_zb_zcl_level_move_with_onoff_cmd_req);
+}
+
+bool ZigBeeComponent::send_level_step(const ZBTarget &target, uint8_t mode, uint8_t step_size,
+                                      uint16_t transition_time) {
+  esp_zb_zcl_level_step_cmd_t cmd_req{};
+  cmd_req.step_mode = mode;
+  cmd_req.step_size = step_size;
+  cmd_req.transition_time = transition_time;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                ESP_ZB_ZCL_CMD_LEVEL_CONTROL_STEP_WITH_ON_OFF, &cmd_req,
+                                esp_zb_zcl_level_step_with_onoff_cmd_req);
+}
+
+bool ZigBeeComponent::send_move_to_color(const ZBTarget &target, uint16_t x, uint16_t y, uint16_t transition_time) {
+  esp_zb_zcl_color_move_to_color_cmd_t cmd_req{};
+  cmd_req.color_x = x;
+  cmd_req.color_y = y;
+  cmd_req.transition_time = transition_time;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CMD_COLOR_CONTROL_MOVE_TO_COLOR,
+                                &cmd_req, esp_zb_zcl_color_move_to_color_cmd_req);
+}
+
+bool ZigBeeComponent::send_recall_scene(const ZBTarget &target, uint16_t group_id, uint8_t scene_id) {
+  esp_zb_zcl_scenes_recall_scene_cmd_t cmd_req{};
+  cmd_req.group_id = group_id;
+  cmd_req.scene_id = scene_id;
+  return this->send_client_cmd_(target, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_CMD_SCENES_RECALL_SCENE, &cmd_req,
+                                esp_zb_zcl_scenes_recall_scene_cmd_req);
+}
+
+void ZigBeeComponent::handle_default_response(esp_zb_zcl_cmd_info_t info, uint8_t resp_to_cmd, uint8_t status) {
+  for (auto &pending : this->pending_cmds_) {
+    if (!pending.active || pending.tsn != info.header.tsn || pending.cluster != info.cluster) {
+      continue;
+    }
+    pending.active = false;
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+      this->client_stats_.failed++;
+      ESP_LOGW(TAG, "Command 0x%02x to 0x%04x failed (cluster 0x%04x, status 0x%02x)", resp_to_cmd,
+               info.src_address.u.short_addr, info.cluster, status);
+      return;
+    }
+    uint32_t latency = millis() - pending.sent;
+    ClientStats &stats = this->client_stats_;
+    stats.delivered++;
+    stats.last_latency = latency;
+    stats.max_latency = std::max(stats.max_latency, latency);
+    stats.avg_latency = stats.delivered == 1 ? latency : stats.avg_latency + (latency - stats.avg_latency) / 8.0f;
+    ESP_LOGD(TAG, "Command 0x%02x delivered to 0x%04x in %u ms", resp_to_cmd, info.src_address.u.short_addr,
+             latency);
+    return;
+  }
+}
+
+// A single timer for all commands, a new command must not push back the deadline of the older ones
+void ZigBeeComponent::arm_client_cmd_timer_(uint32_t delay) {
+  this->client_cmd_timer_ = true;
+  this->set_timeout("client_cmd", delay, [this]() { this->expire_client_cmds_(); });
+}
+
+void ZigBeeComponent::expire_client_cmds_() {
+  this->client_cmd_timer_ = false;
+  uint32_t now = millis();
+  uint32_t next = UINT32_MAX;
+  for (auto &pending : this->pending_cmds_) {
+    if (!pending.active) {
+      continue;
+    }
+    uint32_t age = now - pending.sent;
+    if (age >= this->command_timeout_) {
+      pending.active = false;
+      this->client_stats_.timeouts++;
+      ESP_LOGD(TAG, "Command 0x%02x (cluster 0x%04x, tsn %u) not confirmed", pending.command, pending.cluster,
+               pending.tsn);
+    } else {
+      next = std::min(next, this->command_timeout_ - age);
+    }
+  }
+  if (next != UINT32_MAX) {
+    this->arm_client_cmd_timer_(next);
+  }
+}
+
+bool ZigBeeComponent::read_attribute(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                                     zb_attr_callback_t callback, uint8_t src_endpoint) {
+  // Coalesce with a read of the same attribute that is still in flight
+  for (auto &request : this->attr_requests_) {
+    if (request.active && !request.write && request.address == address && request.endpoint == endpoint &&
+        request.cluster == cluster && request.attr_id == attr_id && request.waiters < MAX_ATTR_REQUEST_WAITERS) {
+      request.callbacks[request.waiters++] = std::move(callback);
+      return true;
+    }
+  }
+  AttrRequest *request = this->find_free_attr_request_();
+  if (request == nullptr || !this->connected_) {
+    if (callback) {
+      callback(ESP_ZB_ZCL_STATUS_FAIL, nullptr);
+    }
+    return false;
+  }
+  esp_zb_zcl_read_attr_cmd_t read_req{};
+  read_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+  read_req.zcl_basic_cmd.dst_addr_u.addr_short = address;
+  read_req.zcl_basic_cmd.dst_endpoint = endpoint;
+  read_req.zcl_basic_cmd.src_endpoint = src_endpoint;
+  read_req.clusterID = cluster;
+  read_req.attr_number = 1;
+  read_req.attr_field = &attr_id;
+  if (!this->try_lock()) {
+    if (callback) {
+      callback(ESP_ZB_ZCL_STATUS_FAIL, nullptr);
+    }
+    return false;
+  }
+  uint8_t tsn = esp_zb_zcl_read_attr_cmd_req(&read_req);
+  esp_zb_lock_release();
+  this->start_attr_request_(request, false, tsn, address, endpoint, cluster, attr_id, std::move(callback));
+  return true;
+}
+
+bool ZigBeeComponent::write_attribute(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                                      uint8_t attr_type, void *value, zb_attr_callback_t callback,
+                                      uint8_t src_endpoint) {
+  AttrRequest *request = this->find_free_attr_request_();
+  if (request == nullptr || !this->connected_) {
+    if (callback) {
+      callback(ESP_ZB_ZCL_STATUS_FAIL, nullptr);
+    }
+    return false;
+  }
+  esp_zb_zcl_attribute_t attribute{};
+  attribute.id = attr_id;
+  attribute.data.type = (esp_zb_zcl_attr_type_t) attr_type;
+  attribute.data.size = zcl_value_size(attr_type, value);
+  attribute.data.value = value;
+  esp_zb_zcl_write_attr_cmd_t write_req{};
+  write_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+  write_req.zcl_basic_cmd.dst_addr_u.addr_short = address;
+  write_req.zcl_basic_cmd.dst_endpoint = endpoint;
+  write_req.zcl_basic_cmd.src_endpoint = src_endpoint;
+  write_req.clusterID = cluster;
+  write_req.attr_number = 1;
+  write_req.attr_field = &attribute;
+  if (!this->try_lock()) {
+    if (callback) {
+      callback(ESP_ZB_ZCL_STATUS_FAIL, nullptr);
+    }
+    return false;
+  }
+  // the frame is built before the call returns, value does not need to outlive it
+  uint8_t tsn = esp_zb_zcl_write_attr_cmd_req(&write_req);
+  esp_zb_lock_release();
+  this->start_attr_request_(request, true, tsn, address, endpoint, cluster, attr_id, std::move(callback));
+  return true;
+}
+
+ZigBeeComponent::AttrRequest *ZigBeeComponent::find_free_attr_request_() {
+  for (auto &request : this->attr_requests_) {
+    if (!request.active) {
+      return &request;
+    }
+  }
+  ESP_LOGW(TAG, "Too many attribute requests in flight");
+  return nullptr;
+}
+
+void ZigBeeComponent::start_attr_request_(AttrRequest *request, bool write, uint8_t tsn, uint16_t address,
+                                          uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                                          zb_attr_callback_t &&callback) {
+  request->active = true;
+  request->write = write;
+  request->tsn = tsn;
+  request->address = address;
+  request->endpoint = endpoint;
+  request->cluster = cluster;
+  request->attr_id = attr_id;
+  request->sent = millis();
+  request->waiters = 1;
+  request->callbacks[0] = std::move(callback);
+  if (!this->attr_request_timer_) {
+    this->arm_attr_request_timer_(this->command_timeout_);
+  }
+}
+
+// A single timer for all requests, a new request must not push back the deadline of the older ones
+void ZigBeeComponent::arm_attr_request_timer_(uint32_t delay) {
+  this->attr_request_timer_ = true;
+  this->set_timeout("attr_request", delay, [this]() { this->expire_attr_requests_(); });
+}
+
+bool ZigBeeComponent::handle_attr_read_response_(esp_zb_zcl_cmd_info_t info,
+                                                 esp_zb_zcl_read_attr_resp_variable_t *variables) {
+  for (auto &request : this->attr_requests_) {
+    if (!request.active || request.write || request.tsn != info.header.tsn || request.cluster != info.cluster) {
+      continue;
+    }
+    if (info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+      this->finish_attr_request_(&request, info.status, nullptr);
+      return true;
+    }
+    for (auto *var = variables; var != nullptr; var = var->next) {
+      if (var->attribute.id == request.attr_id) {
+        this->finish_attr_request_(&request, var->status,
+                                   var->status == ESP_ZB_ZCL_STATUS_SUCCESS ? &var->attribute : nullptr);
+        return true;
+      }
+    }
+    this->finish_attr_request_(&request, ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB, nullptr);
+    return true;
+  }
+  return false;
+}
+
+void ZigBeeComponent::handle_write_attribute_response(esp_zb_zcl_cmd_info_t info, uint8_t status, uint16_t attr_id) {
+  for (auto &request : this->attr_requests_) {
+    if (request.active && request.write && request.tsn == info.header.tsn && request.cluster == info.cluster) {
+      this->finish_attr_request_(&request, status, nullptr);
+      return;
+    }
+  }
+  ESP_LOGD(TAG, "Write attribute response (tsn %u, status 0x%02x, attribute 0x%04x) without request", info.header.tsn,
+           status, attr_id);
+}
+
+void ZigBeeComponent::finish_attr_request_(AttrRequest *request, uint8_t status,
+                                           const esp_zb_zcl_attribute_t *attribute) {
+  ESP_LOGD(TAG, "%s attribute 0x%04x (cluster 0x%04x) of 0x%04x: status 0x%02x", request->write ? "Write" : "Read",
+           request->attr_id, request->cluster, request->address, status);
+  // Free the slot before the callbacks run, they may start new requests
+  zb_attr_callback_t callbacks[MAX_ATTR_REQUEST_WAITERS];
+  uint8_t waiters = request->waiters;
+  for (uint8_t i = 0; i < waiters; i++) {
+    callbacks[i] = std::move(request->callbacks[i]);
+    request->callbacks[i] = nullptr;
+  }
+  request->active = false;
+  request->waiters = 0;
+  for (uint8_t i = 0; i < waiters; i++) {
+    if (callbacks[i]) {
+      callbacks[i](status, attribute);
+    }
+  }
+}
+
+void ZigBeeComponent::expire_attr_requests_() {
+  this->attr_request_timer_ = false;
+  for (auto &request : this->attr_requests_) {
+    // read per entry, a callback may have started a request in a later slot
+    if (request.active && millis() - request.sent >= this->command_timeout_) {
+      this->finish_attr_request_(&request, ESP_ZB_ZCL_STATUS_TIMEOUT, nullptr);
+    }
+  }
+  // callbacks may have started new requests, rearm for the oldest one left
+  uint32_t now = millis();
+  uint32_t next = UINT32_MAX;
+  for (auto &request : this->attr_requests_) {
+    if (request.active) {
+      uint32_t age = now - request.sent;
+      next = std::min(next, age < this->command_timeout_ ? this->command_timeout_ - age : 0);
+    }
+  }
+  if (next != UINT32_MAX) {
+    this->arm_attr_request_timer_(next);
+  }
+}
+
+void ZigBeeComponent::update_mirror_(esp_zb_zcl_addr_t src_address, uint8_t endpoint, uint16_t cluster,
+                                     const esp_zb_zcl_attribute_t &attribute) {
+  if (this->mirror_size_ == 0 || src_address.addr_type != ESP_ZB_ZCL_ADDR_TYPE_SHORT) {
+    return;
+  }
+  uint8_t size = zcl_numeric_size(attribute.data.type);
+  if (attribute.data.value == nullptr || size == 0) {
+    return;
+  }
+  uint64_t key = mirror_key_(src_address.u.short_addr, endpoint, cluster, attribute.id);
+  uint32_t now = millis();
+  MirrorEntry entry{key, attribute.data.type, {}, now, now};
+  memcpy(entry.data, attribute.data.value, size);
+  auto it = this->mirror_index_.find(key);
+  if (it != this->mirror_index_.end()) {
+    this->mirror_[it->second] = entry;
+    return;
+  }
+  uint8_t pos;
+  if (this->mirror_.size() < this->mirror_size_) {
+    pos = this->mirror_.size();
+    this->mirror_.push_back({});
+  } else {
+    // Evict the least recently used entry
+    pos = 0;
+    for (uint8_t i = 1; i < this->mirror_.size(); i++) {
+      if ((int32_t) (this->mirror_[i].last_used - this->mirror_[pos].last_used) < 0) {
+        pos = i;
+      }
+    }
+    this->mirror_index_.erase(this->mirror_[pos].key);
+  }
+  this->mirror_[pos] = entry;
+  this->mirror_index_[key] = pos;
+}
+
+const MirrorEntry *ZigBeeComponent::find_remote_attr(uint16_t address, uint8_t endpoint, uint16_t cluster,
+                                                     uint16_t attr_id) {
+  auto it = this->mirror_index_.find(mirror_key_(address, endpoint, cluster, attr_id));
+  if (it == this->mirror_index_.end()) {
+    return nullptr;
+  }
+  MirrorEntry &entry = this->mirror_[it->second];
+  uint32_t now = millis();
+  if (this->mirror_ttl_ != 0 && now - entry.updated > this->mirror_ttl_) {
+    return nullptr;  // stale, left for eviction
+  }
+  entry.last_used = now;
+  return &entry;
+}
+
+// Packed scenes are entries of cluster (2 bytes), attribute id (2), type (1) and the value, all little endian
+static constexpr uint8_t SCENE_ENTRY_HEADER = 5;
+
+static uint16_t get_u16_le(const uint8_t *data) { return data[0] | (data[1] << 8); }
+
+// Size of the entry at pos, 0 at the end of the data and for entries cut off or with a type of no scalar size
+static uint8_t get_scene_entry_size(const uint8_t *data, uint8_t size, uint8_t pos) {
+  if (pos + SCENE_ENTRY_HEADER > size) {
+    return 0;
+  }
+  uint8_t value_size = zcl_fixed_size(data[pos + 4]);
+  if (value_size == 0 || value_size > sizeof(uint64_t) || pos + SCENE_ENTRY_HEADER + value_size > size) {
+    return 0;
+  }
+  return SCENE_ENTRY_HEADER + value_size;
+}
+
+static const uint8_t *get_scene_value(const uint8_t *data, uint8_t size, uint16_t cluster, uint16_t attr_id) {
+  for (uint8_t pos = 0, entry; (entry = get_scene_entry_size(data, size, pos)) != 0; pos += entry) {
+    if (get_u16_le(data + pos) == cluster && get_u16_le(data + pos + 2) == attr_id) {
+      return data + pos + SCENE_ENTRY_HEADER;
+    }
+  }
+  return nullptr;
+}
+
+static bool set_scene_value(uint8_t *data, uint8_t *size, uint16_t cluster, uint16_t attr_id, uint8_t type,
+                            const void *value) {
+  uint8_t value_size = zcl_fixed_size(type);
+  if (value_size == 0 || value_size > sizeof(uint64_t)) {
+    return false;  // strings, arrays and keys are not part of scenes
+  }
+  uint8_t *existing = (uint8_t *) get_scene_value(data, *size, cluster, attr_id);
+  if (existing != nullptr && existing[-1] == type) {
+    memcpy(existing, value, value_size);
+    return true;
+  }
+  if (existing != nullptr || *size + SCENE_ENTRY_HEADER + value_size > MAX_ZB_SCENE_DATA) {
+    return false;
+  }
+  uint8_t *entry = data + *size;
+  entry[0] = cluster & 0xFF;
+  entry[1] = cluster >> 8;
+  entry[2] = attr_id & 0xFF;
+  entry[3] = attr_id >> 8;
+  entry[4] = type;
+  memcpy(entry + SCENE_ENTRY_HEADER, value, value_size);
+  *size += SCENE_ENTRY_HEADER + value_size;
+  return true;
+}
+
+static void get_scene_key(char *key, uint8_t endpoint, uint16_t group_id, uint8_t scene_id) {
+  snprintf(key, NVS_KEY_NAME_MAX_SIZE, "s%02x%04x%02x", endpoint, group_id, scene_id);
+}
+
+static void save_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, const uint8_t *data, uint8_t size) {
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  get_scene_key(key, endpoint, group_id, scene_id);
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(SCENES_NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(handle, key, data, size);
+    if (err == ESP_OK) {
+      err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Could not store scene %u of group 0x%04x: %s", scene_id, group_id, esp_err_to_name(err));
+  }
+}
+
+static uint8_t load_scene(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, uint8_t *data) {
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  get_scene_key(key, endpoint, group_id, scene_id);
+  nvs_handle_t handle;
+  if (nvs_open(SCENES_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+    return 0;
+  }
+  size_t size = MAX_ZB_SCENE_DATA;
+  if (nvs_get_blob(handle, key, data, &size) != ESP_OK) {
+    size = 0;
+  }
+  nvs_close(handle);
+  // A corrupt scene would shift all following entries, it is dropped as a whole
+  uint8_t pos = 0;
+  for (uint8_t entry; (entry = get_scene_entry_size(data, size, pos)) != 0; pos += entry) {
+  }
+  return pos == size ? size : 0;
+}
+
+// Removes the stored scene, or all scenes of the group with a negative scene_id
+static void erase_scenes(uint8_t endpoint, uint16_t group_id, int16_t scene_id) {
+  char prefix[NVS_KEY_NAME_MAX_SIZE];
+  get_scene_key(prefix, endpoint, group_id, scene_id >= 0 ? scene_id : 0);
+  if (scene_id < 0) {
+    prefix[7] = '\0';  // "s" endpoint group, without the scene
+  }
+  nvs_handle_t handle;
+  if (nvs_open(SCENES_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+    return;
+  }
+  if (scene_id >= 0) {
+    if (nvs_erase_key(handle, prefix) == ESP_OK) {
+      nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return;
+  }
+  // Collect the keys first, erasing invalidates the iterator
+  std::vector<std::string> keys;
+  nvs_iterator_t it = nullptr;
+  esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, SCENES_NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+  while (err == ESP_OK) {
+    nvs_entry_info_t info;
+    nvs_entry_info(it, &info);
+    if (strncmp(info.key, prefix, strlen(prefix)) == 0) {
+      keys.emplace_back(info.key);
+    }
+    err = nvs_entry_next(&it);
+  }
+  nvs_release_iterator(it);
+  for (auto &key : keys) {
+    nvs_erase_key(handle, key.c_str());
+  }
+  if (!keys.empty()) {
+    nvs_commit(handle);
+  }
+  nvs_close(handle);
+}
+
+// Runs in the Zigbee task before the stack handles the command, returns true if the command was answered here.
+// Custom cluster commands go to the synchronous handlers. The stack keeps its scene table itself, the stored values
+// of removed scenes are erased here so that a scene added again does not recall stale values.
+static bool zb_raw_command_handler(uint8_t bufid) {
+  zb_zcl_parsed_hdr_t *cmd_info = ZB_BUF_GET_PARAM(bufid, zb_zcl_parsed_hdr_t);
+  if (cmd_info->is_common_command) {
+    return false;
+  }
+  if (cmd_info->cluster_id >= 0xFC00) {
+    return global_zigbee->on_raw_custom_command(bufid);
+  }
+  if (cmd_info->cluster_id != ZB_ZCL_CLUSTER_ID_SCENES || cmd_info->cmd_direction != ZB_ZCL_FRAME_DIRECTION_TO_SRV) {
+    return false;
+  }
+  const uint8_t *payload = (const uint8_t *) zb_buf_begin(bufid);
+  uint16_t length = zb_buf_len(bufid);
+  uint8_t endpoint = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).dst_endpoint;
+  switch (cmd_info->cmd_id) {
+    case ZB_ZCL_CMD_SCENES_ADD_SCENE:
+    case ZB_ZCL_CMD_SCENES_ENHANCED_ADD_SCENE:
+    case ZB_ZCL_CMD_SCENES_REMOVE_SCENE:
+      if (length >= 3) {
+        erase_scenes(endpoint, get_u16_le(payload), payload[2]);
+      }
+      break;
+    case ZB_ZCL_CMD_SCENES_REMOVE_ALL_SCENES:
+      if (length >= 2) {
+        erase_scenes(endpoint, get_u16_le(payload), -1);
+      }
+      break;
+    default:
+      break;
+  }
+  return false;  // always handled by the stack as well
+}
+
+// FNV-1a over the persisted attributes, stored values of another configuration are discarded
+uint32_t ZigBeeComponent::persist_layout_hash_() {
+  uint32_t hash = 2166136261UL;
+  auto add = [&hash](uint32_t value, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++) {
+      hash = (hash ^ ((value >> (8 * i)) & 0xFF)) * 16777619UL;
+    }
+  };
+  for (auto &attr : this->persisted_attrs_) {
+    add(attr.endpoint_id, 1);
+    add(attr.cluster_id, 2);
+    add(attr.role, 1);
+    add(attr.attr_id, 2);
+    add(attr.attr_type, 1);
+  }
+  return hash;
+}
+
+// Called before the clusters are registered, so the stack starts with the stored values
+void ZigBeeComponent::restore_persisted_attrs_() {
+  if (this->persisted_attrs_.empty()) {
+    return;
+  }
+  size_t size = sizeof(uint32_t);
+  for (auto &attr : this->persisted_attrs_) {
+    size += zcl_fixed_size(attr.attr_type);
+  }
+  std::vector<uint8_t> blob(size);
+  nvs_handle_t handle;
+  if (nvs_open(ATTRS_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+    return;
+  }
+  esp_err_t err = nvs_get_blob(handle, "values", blob.data(), &size);
+  nvs_close(handle);
+  uint32_t hash = this->persist_layout_hash_();
+  if (err != ESP_OK || size != blob.size() || memcmp(blob.data(), &hash, sizeof(hash)) != 0) {
+    ESP_LOGD(TAG, "No stored attribute values for this configuration");
+    return;
+  }
+  size_t pos = sizeof(uint32_t);
+  for (auto &attr : this->persisted_attrs_) {
+    auto it = this->attribute_list_.find({attr.endpoint_id, attr.cluster_id, attr.role});
+    if (it == this->attribute_list_.end() ||
+        esp_zb_cluster_update_attr(it->second, attr.attr_id, blob.data() + pos) != ESP_OK) {
+      ESP_LOGW(TAG, "Could not restore attribute 0x%04X in cluster 0x%04X in endpoint %u", attr.attr_id,
+               attr.cluster_id, attr.endpoint_id);
+    }
+    pos += zcl_fixed_size(attr.attr_type);
+  }
+  ESP_LOGD(TAG, "Restored %u attribute values", (unsigned) this->persisted_attrs_.size());
+  this->persisted_blob_ = std::move(blob);
+}
+
+void ZigBeeComponent::schedule_persist() {
+  if (this->persist_pending_) {
+    return;  // changes until the timeout fires share one write
+  }
+  this->persist_pending_ = true;
+  this->set_timeout("persist", this->persist_interval_, [this]() { this->save_persisted_attrs_(); });
+}
+
+void ZigBeeComponent::save_persisted_attrs_(bool shutdown) {
+  std::vector<uint8_t> blob(sizeof(uint32_t));
+  uint32_t hash = this->persist_layout_hash_();
+  memcpy(blob.data(), &hash, sizeof(hash));
+  if (shutdown) {
+    esp_zb_lock_acquire(portMAX_DELAY);
+  } else if (!this->try_lock()) {
+    this->set_timeout("persist", 1000, [this]() { this->save_persisted_attrs_(); });
+    return;
+  }
+  for (auto &attr : this->persisted_attrs_) {
+    esp_zb_zcl_attr_t *zcl_attr =
+        esp_zb_zcl_get_attribute(attr.endpoint_id, attr.cluster_id, attr.role, attr.attr_id);
+    if (zcl_attr == nullptr || zcl_attr->data_p == nullptr) {
+      esp_zb_lock_release();
+      this->persist_pending_ = false;
+      ESP_LOGW(TAG, "Attribute 0x%04X in cluster 0x%04X not found, values not stored", attr.attr_id,
+               attr.cluster_id);
+      return;
+    }
+    const uint8_t *data = (const uint8_t *) zcl_attr->data_p;
+    blob.insert(blob.end(), data, data + zcl_fixed_size(attr.attr_type));
+  }
+  esp_zb_lock_release();
+  this->persist_pending_ = false;
+  if (blob == this->persisted_blob_) {
+    return;
+  }
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(ATTRS_NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(handle, "values", blob.data(), blob.size());
+    if (err == ESP_OK) {
+      err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Could not store attribute values: %s", esp_err_to_name(err));
+    return;
+  }
+  this->persisted_blob_ = std::move(blob);
+  this->persist_writes_++;
+}
+
+void ZigBeeComponent::on_shutdown() {
+  if (this->persist_pending_) {
+    this->cancel_timeout("persist");
+    this->save_persisted_attrs_(true);
+  }
+}
+
+// Runs in the Zigbee task. Captures the registered server attributes of the endpoint.
+esp_err_t ZigBeeComponent::on_store_scene(const esp_zb_zcl_store_scene_message_t *message) {
+  ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+  uint8_t endpoint = message->info.dst_endpoint;
+  uint8_t data[MAX_ZB_SCENE_DATA];
+  uint8_t size = 0;
+  for (auto &[key, attr] : this->attributes_) {
+    auto [endpoint_id, cluster, role, attr_id] = key;
+    if (endpoint_id != endpoint || role != ESP_ZB_ZCL_CLUSTER_SERVER_ROLE) {
+      continue;
+    }
+    esp_zb_zcl_attr_t *zcl_attr = esp_zb_zcl_get_attribute(endpoint, cluster, role, attr_id);
+    if (zcl_attr == nullptr || zcl_attr->data_p == nullptr || zcl_fixed_size(zcl_attr->type) == 0 ||
+        zcl_fixed_size(zcl_attr->type) > sizeof(uint64_t)) {
+      continue;
+    }
+    if (!set_scene_value(data, &size, cluster, attr_id, zcl_attr->type, zcl_attr->data_p)) {
+      ZB_DEFER_LOGW(ZB_LOG_SCENE_FULL, message->scene_id, attr_id, cluster);
+    }
+  }
+  ZB_DEFER_LOGD(ZB_LOG_SCENE_STORE, message->scene_id, message->group_id, endpoint, size);
+  save_scene(endpoint, message->group_id, message->scene_id, data, size);
+
+  // Keep the scene table of the stack in sync for view scene and scene membership
+  esp_zb_zcl_scenes_extension_field_t fields[3]{};
+  uint8_t count = 0;
+  const uint8_t *value = get_scene_value(data, size, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID);
+  if (value != nullptr) {
+    fields[count].cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF;
+    fields[count].length = 1;
+    fields[count++].extension_field_attribute_value_list = (uint8_t *) value;
+  }
+  value =
+      get_scene_value(data, size, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID);
+  if (value != nullptr) {
+    fields[count].cluster_id = ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL;
+    fields[count].length = 1;
+    fields[count++].extension_field_attribute_value_list = (uint8_t *) value;
+  }
+  const uint8_t *x =
+      get_scene_value(data, size, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID);
+  const uint8_t *y =
+      get_scene_value(data, size, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID);
+  uint8_t color[4];
+  if (x != nullptr && y != nullptr) {
+    memcpy(color, x, 2);
+    memcpy(color + 2, y, 2);
+    fields[count].cluster_id = ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL;
+    fields[count].length = sizeof(color);
+    fields[count++].extension_field_attribute_value_list = color;
+  }
+  for (uint8_t i = 1; i < count; i++) {
+    fields[i - 1].next = &fields[i];
+  }
+  esp_zb_zcl_scenes_table_store(endpoint, message->group_id, message->scene_id, 0, count > 0 ? fields : nullptr);
+  return ESP_OK;
+}
+
+// Runs in the Zigbee task. Applies the stored scene and the extension fields known by the stack, which are set by
+// add scene commands of the coordinator, then passes all values to the main loop as one event.
+esp_err_t ZigBeeComponent::on_recall_scene(const esp_zb_zcl_recall_scene_message_t *message) {
+  ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+  uint8_t endpoint = message->info.dst_endpoint;
+  uint8_t data[MAX_ZB_SCENE_DATA];
+  uint8_t size = load_scene(endpoint, message->group_id, message->scene_id, data);
+  for (auto *field = message->field_set; field != nullptr; field = field->next) {
+    const uint8_t *value = field->extension_field_attribute_value_list;
+    if (field->cluster_id == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF && field->length >= 1) {
+      set_scene_value(data, &size, field->cluster_id, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL,
+                      value);
+    } else if (field->cluster_id == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL && field->length >= 1) {
+      set_scene_value(data, &size, field->cluster_id, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                      ESP_ZB_ZCL_ATTR_TYPE_U8, value);
+    } else if (field->cluster_id == ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL && field->length >= 4) {
+      set_scene_value(data, &size, field->cluster_id, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID,
+                      ESP_ZB_ZCL_ATTR_TYPE_U16, value);
+      set_scene_value(data, &size, field->cluster_id, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID,
+                      ESP_ZB_ZCL_ATTR_TYPE_U16, value + 2);
+    }
+  }
+  ZB_DEFER_LOGD(ZB_LOG_SCENE_RECALL, message->scene_id, message->group_id, endpoint, size);
+  if (size == 0) {
+    return ESP_OK;
+  }
+  for (uint8_t pos = 0, entry; (entry = get_scene_entry_size(data, size, pos)) != 0; pos += entry) {
+    esp_zb_zcl_set_attribute_val(endpoint, get_u16_le(data + pos), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 get_u16_le(data + pos + 2), data + pos + SCENE_ENTRY_HEADER, false);
+  }
+  enqueue_zb_event(endpoint, (const uint8_t *) data, size);
+  return ESP_OK;
+}
+
+void ZigBeeComponent::handle_scene_recall(uint8_t endpoint, const uint8_t *data, uint8_t size, const ZBRxInfo &rx) {
+#ifdef USE_LIGHT
+  // All attributes of a light are applied with one light call
+  LightBatch::begin();
+#endif
+  for (uint8_t pos = 0, entry; (entry = get_scene_entry_size(data, size, pos)) != 0; pos += entry) {
+    uint16_t cluster = get_u16_le(data + pos);
+    uint16_t attr_id = get_u16_le(data + pos + 2);
+    uint8_t type = data[pos + 4];
+    auto attr = this->attributes_.find({endpoint, cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id});
+    if (attr == this->attributes_.end()) {
+      continue;
+    }
+    uint64_t value = 0;  // aligned copy
+    memcpy(&value, data + pos + SCENE_ENTRY_HEADER, zcl_fixed_size(type));
+    esp_zb_zcl_attribute_t attribute = {
+        .id = attr_id,
+        .data =
+            {
+                .type = (esp_zb_zcl_attr_type_t) type,
+                .size = zcl_fixed_size(type),
+                .value = &value,
+            },
+    };
+    attr->second->on_value(attribute, rx);
+  }
+#ifdef USE_LIGHT
+  LightBatch::end();
+#endif
+}
+
 void ZigBeeComponent::handle_attribute(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute,
-                                       uint8_t *current_level) {
+                                       uint8_t *current_level, const ZBRxInfo &rx) {
   if (this->attributes_.find({info.dst_endpoint, info.cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attribute.id}) !=
       this->attributes_.end()) {
     this->attributes_[{info.dst_endpoint, info.cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attribute.id}]->on_value(
-        attribute);
+        attribute, rx);
     // if the attribute is On/Off and it is set to Off, restore the previous level
     if (info.cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF && current_level != nullptr) {
       if (attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL &&
@@ -347,7 +1581,7 @@ void ZigBeeComponent::handle_attribute(esp_zb_device_cb_common_info_t info, esp_
           };
           this->attributes_[{info.dst_endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
                              ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID}]
-              ->on_value(lvl_attr);
+              ->on_value(lvl_attr, rx);
           ESP_LOGD(TAG, "Light set to restore-level: %d", *current_level);
         }
       }
@@ -356,18 +1590,32 @@ void ZigBeeComponent::handle_attribute(esp_zb_device_cb_common_info_t info, esp_
 }
 
 void ZigBeeComponent::handle_report_attribute(uint8_t dst_endpoint, uint16_t cluster, esp_zb_zcl_attribute_t attribute,
-                                              esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) {
+                                              esp_zb_zcl_addr_t src_address, uint8_t src_endpoint,
+                                              const ZBRxInfo &rx) {
+  this->update_mirror_(src_address, src_endpoint, cluster, attribute);
   auto attr = this->attributes_.find({dst_endpoint, cluster, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE, attribute.id});
   if (attr == this->attributes_.end()) {
     ESP_LOGD(TAG, "No attributes configured for report (endpoint %d; cluster 0x%04x; attribute id 0x%04x)",
              dst_endpoint, cluster, attribute.id);
     return;
   }
-  attr->second->on_report(attribute, src_address, src_endpoint);
+  attr->second->on_report(attribute, src_address, src_endpoint, rx);
 }
 
 void ZigBeeComponent::handle_read_attribute_response(esp_zb_zcl_cmd_info_t info,
                                                      esp_zb_zcl_read_attr_resp_variable_t *variables) {
+  for (auto *var = variables; var != nullptr; var = var->next) {
+    if (var->status == ESP_ZB_ZCL_STATUS_SUCCESS) {
+      this->update_mirror_(info.src_address, info.src_endpoint, info.cluster, var->attribute);
+    }
+  }
+  if (this->handle_attr_read_response_(info, variables)) {
+    return;
+  }
+  if (info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+    ESP_LOGD(TAG, "Read attribute response (tsn %u, status 0x%02x) without request", info.header.tsn, info.status);
+    return;
+  }
   switch (info.cluster) {
     case ESP_ZB_ZCL_CLUSTER_ID_TIME:
       ESP_LOGD(TAG, "Recieved time information");
@@ -375,7 +1623,7 @@ void ZigBeeComponent::handle_read_attribute_response(esp_zb_zcl_cmd_info_t info,
       if (this->zt_ == nullptr) {
         ESP_LOGD(TAG, "No time component linked to update time!");
       } else {
-        this->zt_->recieve_timesync_response(variables);
+        this->zt_->recieve_timesync_response(info.header.tsn, variables);
       }
 #else
       ESP_LOGD(TAG, "No zigbee time component included at build time!");
@@ -468,6 +1716,96 @@ esp_zb_attribute_list_t *ZigBeeComponent::create_basic_cluster_() {
   return attr_list;
 }
 
+#ifdef USE_ZIGBEE_TIME
+void ZigBeeComponent::create_time_server_() {
+  uint8_t endpoint_id = this->time_server_endpoint_;
+  if (this->endpoint_list_.find(endpoint_id) == this->endpoint_list_.end()) {
+    ESP_LOGE(TAG, "Could not create time server, endpoint %u does not exist", endpoint_id);
+    return;
+  }
+  if (this->attribute_list_.find({endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE}) ==
+      this->attribute_list_.end()) {
+    this->add_cluster(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+  }
+  // Time is invalid and no status bits are set until the first sync
+  this->add_attr(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_TIME_TIME_ID,
+                 ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, 0, (uint32_t) 0xFFFFFFFF);
+  this->add_attr(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_TIME, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                 ESP_ZB_ZCL_ATTR_TIME_TIME_STATUS_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, 0,
+                 (uint8_t) 0);
+}
+#endif
+
+bool ZigBeeComponent::get_ieee_address(uint16_t short_addr, uint64_t *ieee_address) {
+  if (this->ieee_addresses_stale_.exchange(false, std::memory_order_relaxed)) {
+    this->ieee_addresses_.clear();
+  }
+  auto it = this->ieee_addresses_.find(short_addr);
+  if (it != this->ieee_addresses_.end()) {
+    *ieee_address = it->second;
+    return true;
+  }
+  esp_zb_ieee_addr_t ieee_addr;
+  if (!this->try_lock()) {
+    return false;
+  }
+  esp_err_t ret = esp_zb_ieee_address_by_short(short_addr, ieee_addr);
+  esp_zb_lock_release();
+  if (ret != ESP_OK) {
+    return false;
+  }
+  memcpy(ieee_address, ieee_addr, sizeof(*ieee_address));
+  if (this->ieee_addresses_.size() >= MAX_IEEE_ADDRESSES) {
+    this->ieee_addresses_.erase(this->ieee_addresses_.begin());
+  }
+  this->ieee_addresses_[short_addr] = *ieee_address;
+  return true;
+}
+
+// Must be called with the Zigbee lock held
+uint16_t ZigBeeComponent::get_parent_address() {
+  esp_zb_nwk_info_iterator_t iterator = ESP_ZB_NWK_INFO_ITERATOR_INIT;
+  esp_zb_nwk_neighbor_info_t neighbor;
+  while (esp_zb_nwk_get_next_neighbor(&iterator, &neighbor) == ESP_OK) {
+    if (neighbor.relationship == ESP_ZB_NWK_RELATIONSHIP_PARENT) {
+      return neighbor.short_addr;
+    }
+  }
+  return 0xFFFF;
+}
+
+bool ZigBeeComponent::get_neighbor_stats(NeighborStats *stats) {
+  *stats = {};
+  if (!this->try_lock()) {
+    return false;
+  }
+  esp_zb_nwk_info_iterator_t iterator = ESP_ZB_NWK_INFO_ITERATOR_INIT;
+  esp_zb_nwk_neighbor_info_t neighbor;
+  uint32_t lqi_sum = 0;
+  int32_t rssi_sum = 0;
+  stats->lqi_min = UINT8_MAX;
+  stats->rssi_min = INT8_MAX;
+  while (esp_zb_nwk_get_next_neighbor(&iterator, &neighbor) == ESP_OK) {
+    stats->neighbors++;
+    if (neighbor.relationship == ESP_ZB_NWK_RELATIONSHIP_CHILD) {
+      stats->children++;
+    }
+    lqi_sum += neighbor.lqi;
+    rssi_sum += neighbor.rssi;
+    stats->lqi_min = std::min(stats->lqi_min, neighbor.lqi);
+    stats->rssi_min = std::min(stats->rssi_min, neighbor.rssi);
+  }
+  esp_zb_lock_release();
+  if (stats->neighbors == 0) {
+    stats->lqi_min = 0;
+    stats->rssi_min = 0;
+    return true;
+  }
+  stats->lqi_avg = (float) lqi_sum / stats->neighbors;
+  stats->rssi_avg = (float) rssi_sum / stats->neighbors;
+  return true;
+}
+
 esp_err_t ZigBeeComponent::create_endpoint(uint8_t endpoint_id, esp_zb_ha_standard_devices_t device_id,
                                            esp_zb_cluster_list_t *esp_zb_cluster_list) {
   // ------------------------------ Create endpoint list ------------------------------
@@ -478,12 +1816,20 @@ esp_err_t ZigBeeComponent::create_endpoint(uint8_t endpoint_id, esp_zb_ha_standa
   return esp_zb_ep_list_add_ep(this->esp_zb_ep_list_, esp_zb_cluster_list, endpoint_config);
 }
 
+// Runs in the Zigbee task, the high watermark only decreases so a sample per second is enough
+static void sample_task_stack_cb(uint8_t param) {
+  global_zigbee->update_task_stack_free();
+  esp_zb_scheduler_alarm((esp_zb_callback_t) sample_task_stack_cb, 0, 1000);
+}
+
 static void esp_zb_task_(void *pvParameters) {
   if (esp_zb_start(false) != ESP_OK) {
     ESP_LOGE(TAG, "Could not setup Zigbee");
     // this->mark_failed();
+    global_zigbee->update_task_stack_free();
     vTaskDelete(NULL);
   }
+  sample_task_stack_cb(0);
 
   if ((global_zigbee->device_role_ == ESP_ZB_DEVICE_TYPE_ED) && (global_zigbee->basic_cluster_data_.power == 0x03)) {
     ESP_LOGD(TAG, "Battery powered!");
@@ -498,6 +1844,9 @@ static void esp_zb_task_(void *pvParameters) {
 void ZigBeeComponent::setup() {
   esp_err_t ret;
   global_zigbee = this;
+  memset(this->channel_energy_, INT8_MIN, sizeof(this->channel_energy_));
+  this->mirror_.reserve(this->mirror_size_);
+  this->mirror_index_.reserve(this->mirror_size_);
   esp_zb_platform_config_t config = {
       .radio_config = ESP_ZB_DEFAULT_RADIO_CONFIG(),
       .host_config = ESP_ZB_DEFAULT_HOST_CONFIG(),
@@ -507,6 +1856,7 @@ void ZigBeeComponent::setup() {
     this->mark_failed();
     return;
   }
+  this->setup_coex_();
 #endif
   // ESP_ERROR_CHECK(nvs_flash_init()); not needed, called by esp32 component
   if (esp_zb_platform_config(&config) != ESP_OK) {
@@ -524,7 +1874,7 @@ void ZigBeeComponent::setup() {
       .keep_alive = this->keep_alive_,
   };
   esp_zb_zczr_cfg_t zb_zczr_cfg = {
-      .max_children = MAX_CHILDREN,
+      .max_children = this->max_children_,
   };
   esp_zb_cfg_t zb_nwk_cfg = {
       .esp_zb_role = this->device_role_,
@@ -535,6 +1885,16 @@ void ZigBeeComponent::setup() {
 #else
   zb_nwk_cfg.nwk_cfg.zed_cfg = zb_zed_cfg;
 #endif
+  // table sizes must be set before the stack is initialized
+  if (this->network_size_ != 0 && esp_zb_overall_network_size_set(this->network_size_) != ESP_OK) {
+    ESP_LOGE(TAG, "Could not set network size to %u", this->network_size_);
+  }
+  if (this->io_buffer_size_ != 0 && esp_zb_io_buffer_size_set(this->io_buffer_size_) != ESP_OK) {
+    ESP_LOGE(TAG, "Could not set IO buffer size to %u", this->io_buffer_size_);
+  }
+  if (this->scheduler_queue_size_ != 0 && esp_zb_scheduler_queue_size_set(this->scheduler_queue_size_) != ESP_OK) {
+    ESP_LOGE(TAG, "Could not set scheduler queue size to %u", this->scheduler_queue_size_);
+  }
   esp_zb_init(&zb_nwk_cfg);
 
   if (this->custom_trust_center_key_) {
@@ -542,6 +1902,31 @@ void ZigBeeComponent::setup() {
     esp_zb_secur_TC_standard_distributed_key_set(this->trustkey_);
   }
 
+#ifdef USE_ZIGBEE_TIME
+  if (this->time_server_endpoint_ != 0) {
+    this->create_time_server_();
+  }
+#endif
+#ifdef USE_ZIGBEE_OTA
+  if (this->ota_endpoint_ != 0) {
+    this->create_ota_client_();
+  }
+#endif
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+  if (this->diagnostics_endpoint_ != 0) {
+    this->create_diagnostics_server_();
+    // the attributes are written by the callback of the stats request
+    this->set_interval("diagnostics", this->diagnostics_interval_, [this]() { this->poll_tx_stats_(); });
+  }
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  if (this->trace_size_ > 0) {
+    this->trace_recorder_.init(this->trace_size_);
+  }
+#endif
+
+  this->restore_persisted_attrs_();
+
   // clusters
   for (auto const &[key, val] : this->attribute_list_) {
     esp_zb_cluster_list_t *esp_zb_cluster_list = std::get<1>(this->endpoint_list_[std::get<0>(key)]);
@@ -569,6 +1954,7 @@ void ZigBeeComponent::setup() {
   }
 
   esp_zb_core_action_handler_register(zb_action_handler);
+  esp_zb_raw_command_handler_register(zb_raw_command_handler);
 
   if (esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK) != ESP_OK) {
     ESP_LOGE(TAG, "Could not setup Zigbee");
@@ -587,20 +1973,39 @@ void ZigBeeComponent::setup() {
       }
     }
   }
-  xTaskCreate(esp_zb_task_, "Zigbee_main", 4096, NULL, 24, NULL);
+  if (xTaskCreate(esp_zb_task_, "Zigbee_main", this->task_stack_size_, NULL, this->task_priority_, NULL) != pdPASS) {
+    ESP_LOGE(TAG, "Could not create Zigbee task with %u bytes stack", this->task_stack_size_);
+    this->mark_failed();
+    return;
+  }
   this->disable_loop();  // loop is only needed for processing events, so disable until we join a network
 }
 
 void ZigBeeComponent::loop() {
+  this->deferred_log_.process();
   // Process all pending events
+  uint8_t batch = 0;
   ZBEvent *event = this->zb_events_.pop();
   while (event != nullptr) {
+    if (batch < UINT8_MAX) {
+      batch++;
+    }
+#ifdef USE_ZIGBEE_BENCHMARK
+    uint32_t dequeued = micros();
+#endif
     // Handle the event
     switch (event->callback_id_) {
       case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
         this->handle_attribute(
             event->event_.set_attr.info, event->event_.set_attr.attribute,
-            event->event_.set_attr.has_current_level ? &event->event_.set_attr.current_level : nullptr);
+            event->event_.set_attr.has_current_level ? &event->event_.set_attr.current_level : nullptr, event->rx_);
+#ifdef USE_ZIGBEE_FAST_PATH
+        // components and automations applied the value
+        if (this->has_fast_output_(event->event_.set_attr.info.dst_endpoint, event->event_.set_attr.info.cluster,
+                                   event->event_.set_attr.attribute.id)) {
+          this->loop_latency_.add(micros() - event->queued_);
+        }
+#endif
         break;
       case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID:
         this->handle_read_attribute_response(event->event_.read_attr_resp.info,
@@ -609,25 +2014,99 @@ void ZigBeeComponent::loop() {
       case ESP_ZB_CORE_REPORT_ATTR_CB_ID:
         this->handle_report_attribute(event->event_.report_attr.dst_endpoint, event->event_.report_attr.cluster,
                                       event->event_.report_attr.attribute, event->event_.report_attr.src_address,
-                                      event->event_.report_attr.src_endpoint);
+                                      event->event_.report_attr.src_endpoint, event->rx_);
+        this->pipeline_stats_.reports_received++;
 
         break;
+      case ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID:
+        this->handle_write_attribute_response(event->event_.write_attr_resp.info, event->event_.write_attr_resp.status,
+                                              event->event_.write_attr_resp.attr_id);
+        break;
+      case ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID:
+        this->handle_default_response(event->event_.default_resp.info, event->event_.default_resp.resp_to_cmd,
+                                      event->event_.default_resp.status);
+        break;
+      case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+        this->handle_scene_recall(event->event_.scene_recall.endpoint, event->event_.scene_recall.data,
+                                  event->event_.scene_recall.size, event->rx_);
+        break;
+      case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        this->handle_custom_command(event->event_.custom_cmd.info, event->event_.custom_cmd.data,
+                                    event->event_.custom_cmd.size, event->rx_);
+        break;
       default:
         ESP_LOGW(TAG, "Received event with unhandled callback id: 0x%x", event->callback_id_);
         break;
     }
 
+#ifdef USE_ZIGBEE_BENCHMARK
+    this->benchmark_.on_dispatch(event->queued_, dequeued);
+#endif
+#ifdef USE_ZIGBEE_TRACE
+    this->trace_replayer_.on_dispatch(event);
+#endif
     // Free the event back to the pool
     this->zb_event_pool_.release(event);
     // Get the next event
     event = this->zb_events_.pop();
   }
+  this->pipeline_stats_.queue_high_water = std::max(this->pipeline_stats_.queue_high_water, batch);
   // Log dropped events periodically
   uint16_t dropped = this->zb_events_.get_and_reset_dropped_count();
+  this->pipeline_stats_.events_dropped += dropped;
+#ifdef USE_ZIGBEE_BENCHMARK
+  if (this->benchmark_.is_running()) {
+    this->benchmark_.add_dropped(dropped);  // counted per run instead
+    dropped = 0;
+  }
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  if (this->trace_replayer_.is_running()) {
+    this->trace_replayer_.add_dropped(dropped);
+    dropped = 0;
+  }
+#endif
   if (dropped > 0) {
     ESP_LOGW(TAG, "Dropped %u Zigbee events due to buffer overflow", dropped);
   }
 
+  if (this->energy_scan_updated_.exchange(false)) {
+    ESP_LOGD(TAG, "Energy scan finished, preferred channel mask: 0x%08" PRIX32, this->preferred_channel_mask_);
+    this->on_energy_scan_callback_.call();
+  }
+  if (this->tx_stats_updated_.exchange(false)) {
+#ifdef CONFIG_WIFI_COEX
+    uint32_t tx_failures = this->get_tx_stats().tx_failures;
+    if (this->coex_policy_ == COEX_POLICY_WIFI && tx_failures > this->coex_last_failures_) {
+      this->coex_boosts_++;
+      this->set_coex_zigbee_priority_(true);
+      this->set_timeout("coex_window", this->coex_window_, [this]() { this->set_coex_zigbee_priority_(false); });
+    }
+    this->coex_last_failures_ = tx_failures;
+#endif
+    if (this->tx_stats_publish_.exchange(false)) {
+      this->on_tx_stats_callback_.call();
+    }
+  }
+#ifdef USE_ZIGBEE_BENCHMARK
+  this->benchmark_.loop();  // takes the injector result while a benchmark is running
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  this->trace_replayer_.loop();
+#endif
+#ifdef USE_ZIGBEE_INJECT
+  if (this->injector_.take_finished()) {
+    const ZBInjectResult &result = this->injector_.get_result();
+    ESP_LOGI(TAG, "Injected %" PRIu32 " events in %" PRIu32 " ms, %" PRIu32 " rejected", result.injected,
+             result.duration, result.rejected);
+  }
+#endif
+#ifdef USE_ZIGBEE_OTA
+  if (this->ota_reboot_) {
+    ESP_LOGI(TAG, "OTA upgrade finished, rebooting");
+    App.safe_reboot();
+  }
+#endif
   if (this->joined_) {
     this->on_join_callback_.call();
     this->joined_ = false;  // only call once
@@ -641,6 +2120,67 @@ void ZigBeeComponent::dump_config() {
   char trustkey_hex[format_hex_pretty_size(sizeof(this->trustkey_))];
   ESP_LOGCONFIG(TAG, "ZigBee:");
   ESP_LOGCONFIG(TAG, "  Device Version: %u", this->device_version_);
+  if (this->device_role_ == ESP_ZB_DEVICE_TYPE_ROUTER) {
+    ESP_LOGCONFIG(TAG, "  Max Children: %u", this->max_children_);
+  }
+  if (this->network_size_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Network Size: %u", this->network_size_);
+  }
+  if (this->io_buffer_size_ != 0) {
+    ESP_LOGCONFIG(TAG, "  IO Buffer Size: %u", this->io_buffer_size_);
+  }
+  if (this->scheduler_queue_size_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Scheduler Queue Size: %u", this->scheduler_queue_size_);
+  }
+  ESP_LOGCONFIG(TAG, "  Task: stack %u bytes (%" PRIu32 " never used), priority %u", this->task_stack_size_,
+                this->get_task_stack_free(), this->task_priority_);
+  ESP_LOGCONFIG(TAG, "  Heap Minimum Free: %" PRIu32 " bytes", this->get_heap_min_free());
+  if (this->energy_scan_on_boot_) {
+    ESP_LOGCONFIG(TAG, "  Energy Scan: duration %u, %u preferred channels", this->energy_scan_duration_,
+                  this->preferred_channels_);
+  }
+#ifdef CONFIG_WIFI_COEX
+  static const char *const COEX_POLICIES[] = {"balanced", "zigbee", "zigbee_window", "wifi"};
+  ESP_LOGCONFIG(TAG, "  Coexistence Policy: %s (window %u ms, period %u ms)", COEX_POLICIES[this->coex_policy_],
+                this->coex_window_, this->coex_period_);
+#endif
+  ESP_LOGCONFIG(TAG, "  Command Timeout: %u ms", this->command_timeout_);
+  ESP_LOGCONFIG(TAG, "  Attribute Mirror: %u entries, ttl %u ms", this->mirror_size_, this->mirror_ttl_);
+#ifdef USE_ZIGBEE_FAST_PATH
+  for (const ZBFastOutput &fast : this->fast_outputs_) {
+    ESP_LOGCONFIG(TAG, "  Fast Output: endpoint %u, cluster 0x%04x, attribute 0x%04x", fast.endpoint, fast.cluster,
+                  fast.attr_id);
+  }
+#endif
+  if (!this->persisted_attrs_.empty()) {
+    ESP_LOGCONFIG(TAG, "  Persisted Attributes: %u (interval %u ms)", (unsigned) this->persisted_attrs_.size(),
+                  this->persist_interval_);
+  }
+#ifdef USE_ZIGBEE_ATTR_STATS
+  this->log_attribute_stats_(ESPHOME_LOG_LEVEL_CONFIG, 0);
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  if (this->trace_recorder_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Event Trace: %zu bytes", this->trace_recorder_.get_size());
+  }
+#endif
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+  if (this->diagnostics_endpoint_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Diagnostics: endpoint %u, cluster 0x%04x, interval %" PRIu32 " ms",
+                  this->diagnostics_endpoint_, this->diagnostics_cluster_, this->diagnostics_interval_);
+  }
+#endif
+#ifdef USE_ZIGBEE_OTA
+  if (this->ota_endpoint_ != 0) {
+    ESP_LOGCONFIG(TAG, "  OTA: endpoint %u, manufacturer 0x%04x, image type 0x%04x, file version 0x%08" PRIx32,
+                  this->ota_endpoint_, this->ota_manufacturer_, this->ota_image_type_, this->ota_file_version_);
+    ESP_LOGCONFIG(TAG, "  OTA Block Size: %u, query interval %u min", this->ota_block_size_,
+                  this->ota_query_interval_);
+  }
+#endif
+  for (auto &[endpoint_id, group] : this->groups_) {
+    ESP_LOGCONFIG(TAG, "  Group: 0x%04x (endpoint %u)", group, endpoint_id);
+  }
   if (this->custom_trust_center_key_) {
     ESP_LOGCONFIG(TAG, "  Custom Trust Center Key: %s",
                   format_hex_pretty_to(trustkey_hex, this->trustkey_, sizeof(this->trustkey_), '.'));
@@ -1,31 +1,63 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <map>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "esphome/core/defines.h"
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
+#include "esphome/core/optional.h"
 #include "esphome/core/lock_free_queue.h"
 #include "esphome/core/event_pool.h"
 
 #include "esp_zb_event.h"
 
+#include "esp_heap_caps.h"
 #include "esp_zigbee_core.h"
 #include "zboss_api.h"
 #include "ha/esp_zigbee_ha_standard.h"
+#include "zigbee_codec.h"
 #include "zigbee_helpers.h"
+#include "zigbee_log.h"
 
 #ifdef USE_ZIGBEE_TIME
 #include "time/zigbee_time.h"
 #endif
+#ifdef USE_ZIGBEE_OTA
+#include "zigbee_ota.h"
+#endif
+#ifdef USE_ZIGBEE_INJECT
+#include "zigbee_inject.h"
+#endif
+#ifdef USE_ZIGBEE_BENCHMARK
+#include "zigbee_benchmark.h"
+#endif
+#ifdef USE_ZIGBEE_TRACE
+#include "zigbee_trace.h"
+#endif
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+#include "zigbee_diagnostics.h"
+#endif
+#ifdef USE_ZIGBEE_FAST_PATH
+#include "zigbee_fast_path.h"
+#endif
 
 namespace esphome {
 namespace zigbee {
 
 static const char *const TAG = "zigbee";
 static constexpr uint8_t MAX_ZB_QUEUE_SIZE = 32;
+static constexpr uint8_t MAX_ATTR_REQUESTS = 8;         // read/write requests in flight
+static constexpr uint8_t MAX_ATTR_REQUEST_WAITERS = 4;  // coalesced reads per request
+static constexpr uint8_t MAX_MIRROR_SIZE = 64;
+static const char *const SCENES_NVS_NAMESPACE = "zb_scenes";
+static const char *const ATTRS_NVS_NAMESPACE = "zb_attrs";
 
 using device_params_t = struct DeviceParamsS {
   esp_zb_ieee_addr_t ieee_addr;
@@ -57,7 +89,100 @@ using zb_device_params_t = struct zb_device_params_s {
 #define ESP_ZB_DEFAULT_HOST_CONFIG() \
   { .host_connection_mode = ZB_HOST_CONNECTION_MODE_NONE, }
 
-template<class T> T get_value_by_type(uint8_t attr_type, void *data);
+struct NeighborStats {
+  uint16_t children;
+  uint16_t neighbors;
+  uint8_t lqi_min;
+  float lqi_avg;
+  int8_t rssi_min;
+  float rssi_avg;
+};
+
+// MAC layer counters since boot
+struct TxStats {
+  uint32_t tx_total;
+  uint32_t tx_failures;
+  uint32_t tx_retries;
+  uint32_t cca_failures;
+  uint32_t drops;
+  uint32_t coex_boosts;
+};
+
+// Counters of the event pipeline since boot, updated in the main loop
+struct PipelineStats {
+  uint32_t events_dropped;
+  uint32_t reports_received;
+  uint32_t reports_sent;
+  uint8_t queue_high_water;  // most events drained in one loop() pass
+};
+
+// View of a received custom cluster command. The payload is only valid while the handler runs.
+struct ZBCommand {
+  uint8_t endpoint;
+  uint16_t cluster;
+  uint8_t command;
+  uint8_t tsn;
+  esp_zb_zcl_addr_t src_address;
+  uint8_t src_endpoint;
+  const uint8_t *data;
+  uint8_t size;
+  ZBRxInfo rx;
+};
+
+// Response generated by a synchronous command handler, sent back to the source of the command
+struct ZBCommandResponse {
+  bool send;
+  uint8_t command;
+  uint8_t size;
+  uint8_t data[MAX_ZB_CMD_PAYLOAD];
+};
+
+// Result of a remote read or write. status is ESP_ZB_ZCL_STATUS_TIMEOUT without response, attribute is only set for
+// successful reads and only valid while the callback runs.
+using zb_attr_callback_t = std::function<void(uint8_t status, const esp_zb_zcl_attribute_t *attribute)>;
+
+// Runs in the main loop
+using zb_command_handler_t = std::function<void(const ZBCommand &command)>;
+// Runs in the Zigbee task, returns the ZCL status of the command
+using zb_sync_command_handler_t = std::function<uint8_t(const ZBCommand &command, ZBCommandResponse *response)>;
+
+// Destination of a client command: bound devices (default), a group or an explicit short address
+struct ZBTarget {
+  uint8_t src_endpoint = 1;
+  uint8_t address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT;
+  uint16_t address = 0;
+  uint8_t dst_endpoint = 0;
+};
+
+// Delivery of client commands, confirmed by the default response of the target
+struct ClientStats {
+  uint32_t sent;
+  uint32_t delivered;
+  uint32_t failed;    // default response with an error status
+  uint32_t timeouts;  // no response within the command timeout
+  uint32_t last_latency;
+  uint32_t max_latency;
+  float avg_latency;  // moving average over the last ~8 commands, in ms
+};
+
+// Last known value of a remote attribute, numeric types only
+struct MirrorEntry {
+  uint64_t key;
+  uint8_t type;
+  uint8_t data[8];     // value in the ZCL encoding, keeps 64 bit integers exact
+  uint32_t updated;    // millis() of the last report or read response
+  uint32_t last_used;  // millis() of the last insert or lookup, for LRU eviction
+
+  template<typename T> T get() const { return get_value_by_type<T>(this->type, this->data); }
+};
+
+enum CoexPolicy : uint8_t {
+  COEX_POLICY_BALANCED = 0,   // driver defaults
+  COEX_POLICY_ZIGBEE,         // Zigbee always preferred
+  COEX_POLICY_ZIGBEE_WINDOW,  // Zigbee preferred for a window every period
+  COEX_POLICY_WIFI,           // WiFi preferred, Zigbee boosted for a window after TX failures
+};
+
 uint8_t *get_zcl_string(const char *str, uint8_t max_size, bool use_max_size = false);
 
 class ZigBeeAttribute;
@@ -77,20 +202,38 @@ class ZigBeeComponent : public Component {
   void set_sleepy(bool sleepy) { this->sleepy_ = sleepy; }
   void set_trust_center_key(const char *trust_center_key);
   void set_device_version(uint8_t version) { this->device_version_ = version; }
+  void set_max_children(uint8_t max_children) { this->max_children_ = max_children; }
+  void set_network_size(uint16_t network_size) { this->network_size_ = network_size; }
+  void set_io_buffer_size(uint16_t io_buffer_size) { this->io_buffer_size_ = io_buffer_size; }
+  void set_scheduler_queue_size(uint16_t scheduler_queue_size) { this->scheduler_queue_size_ = scheduler_queue_size; }
+  void set_task(uint16_t stack_size, uint8_t priority) {
+    this->task_stack_size_ = stack_size;
+    this->task_priority_ = priority;
+  }
+  // Smallest free stack of the Zigbee task since it started in bytes, 0 before the start. Sampled by the task itself,
+  // the task may be deleted if the stack could not start.
+  uint32_t get_task_stack_free() const { return this->task_stack_free_.load(std::memory_order_relaxed); }
+  // Called by the Zigbee task
+  void update_task_stack_free() {
+    this->task_stack_free_.store(uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t), std::memory_order_relaxed);
+  }
+  // Smallest free heap since boot in bytes
+  uint32_t get_heap_min_free() { return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT); }
   void add_cluster(uint8_t endpoint_id, uint16_t cluster_id, uint8_t role);
   void create_default_cluster(uint8_t endpoint_id, esp_zb_ha_standard_devices_t device_id);
 
   template<typename T>
   void add_attr(ZigBeeAttribute *attr, uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id,
-                uint8_t attr_type, uint8_t attr_access, uint8_t max_size, T value);
+                uint8_t attr_type, uint8_t attr_access, uint16_t max_size, T value);
 
   template<typename T>
   void add_attr(uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id, uint8_t attr_type,
-                uint8_t attr_access, uint8_t max_size, T value);
+                uint8_t attr_access, uint16_t max_size, T value);
 
-  void handle_attribute(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute, uint8_t *current_level);
+  void handle_attribute(esp_zb_device_cb_common_info_t info, esp_zb_zcl_attribute_t attribute, uint8_t *current_level,
+                        const ZBRxInfo &rx);
   void handle_report_attribute(uint8_t dst_endpoint, uint16_t cluster, esp_zb_zcl_attribute_t attribute,
-                               esp_zb_zcl_addr_t src_address, uint8_t src_endpoint);
+                               esp_zb_zcl_addr_t src_address, uint8_t src_endpoint, const ZBRxInfo &rx);
   void handle_read_attribute_response(esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_attr_resp_variable_t *variables);
   void searchBindings();
   static void bindingTableCb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx);
@@ -104,19 +247,209 @@ class ZigBeeComponent : public Component {
 
 #ifdef USE_ZIGBEE_TIME
   ZigbeeTime *zt_{nullptr};
+  void add_time_server(uint8_t endpoint_id) { this->time_server_endpoint_ = endpoint_id; }
+#endif
+#ifdef USE_ZIGBEE_OTA
+  // OTA Upgrade client, images are streamed into the inactive app partition in the Zigbee task
+  void set_ota(uint8_t endpoint_id, uint16_t manufacturer, uint16_t image_type, uint32_t file_version,
+               uint8_t block_size, uint16_t query_interval) {
+    this->ota_endpoint_ = endpoint_id;
+    this->ota_manufacturer_ = manufacturer;
+    this->ota_image_type_ = image_type;
+    this->ota_file_version_ = file_version;
+    this->ota_block_size_ = block_size;
+    this->ota_query_interval_ = query_interval;
+  }
+  esp_err_t on_ota_query_response(const esp_zb_zcl_ota_upgrade_query_image_resp_message_t *message);
+  esp_err_t on_ota_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message);
 #endif
+#ifdef USE_ZIGBEE_INJECT
+  // Synthetic stack callbacks to exercise the event pipeline, the result is logged by loop()
+  bool inject_events(const ZBInjectConfig &config) { return this->injector_.start(this, config); }
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  void set_trace_size(size_t size) { this->trace_size_ = size; }
+  // Called by zb_action_handler in the Zigbee task
+  void record_trace(ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, const esp_zb_zcl_attribute_t &attribute) {
+    this->trace_recorder_.record(event, endpoint, cluster, attribute);
+  }
+  // Logs the recorded events as hex lines that can be passed to zigbee.trace_replay
+  void dump_trace(bool clear);
+  // Replays the trace or the recorded events if it is empty, speed 0 replays as fast as possible
+  bool replay_trace(std::vector<uint8_t> trace, float speed);
+#endif
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+  // Diagnostics cluster server, filled from the stack and pipeline counters every interval
+  void set_diagnostics(uint8_t endpoint_id, uint32_t interval, uint16_t cluster_id) {
+    this->diagnostics_endpoint_ = endpoint_id;
+    this->diagnostics_interval_ = interval;
+    this->diagnostics_cluster_ = cluster_id;
+  }
+  // Runs in the Zigbee task
+  void update_diagnostics(const zdo_diagnostics_full_stats_t &stats);
+#endif
+#ifdef USE_ZIGBEE_FAST_PATH
+  // Outputs must be added before setup(), the list is read by the Zigbee task without locking
+  void add_fast_output(uint8_t endpoint, uint16_t cluster, uint16_t attr_id, output::BinaryOutput *output) {
+    this->fast_outputs_.push_back({endpoint, cluster, attr_id, output});
+  }
+  // Runs in the Zigbee task, start is micros() when the stack passed the attribute
+  void apply_fast_output(uint8_t endpoint, uint16_t cluster, const esp_zb_zcl_attribute_t &attribute, uint32_t start);
+  ZBLatencyStats get_fast_path_latency();
+  ZBLatencyStats get_loop_path_latency() const { return this->loop_latency_; }
+#endif
+#ifdef USE_ZIGBEE_ATTR_STATS
+  // Attributes with traffic, busiest first, at most count or all if count is 0
+  std::vector<ZigBeeAttribute *> get_busiest_attributes(uint8_t count);
+  void dump_attribute_stats(uint8_t count) { this->log_attribute_stats_(ESPHOME_LOG_LEVEL_INFO, count); }
+#endif
+#ifdef USE_ZIGBEE_BENCHMARK
+  bool run_benchmark(const ZBBenchmarkConfig &config) { return this->benchmark_.start(&this->injector_, this, config); }
+#endif
+  uint16_t get_parent_address();
+  // IEEE address of a device on the network as integer (byte 7 of esp_zb_ieee_addr_t is the most significant),
+  // cached after the first lookup. Called from the main loop.
+  bool get_ieee_address(uint16_t short_addr, uint64_t *ieee_address);
+  // Called by the Zigbee task when devices join or leave, the cache is cleared on the next lookup
+  void invalidate_ieee_addresses() { this->ieee_addresses_stale_.store(true, std::memory_order_relaxed); }
+  bool get_neighbor_stats(NeighborStats *stats);
+
+  void set_energy_scan(bool on_boot, uint8_t duration, uint8_t preferred_channels) {
+    this->energy_scan_on_boot_ = on_boot;
+    this->energy_scan_duration_ = duration;
+    this->preferred_channels_ = preferred_channels;
+  }
+  void start_energy_scan();
+  void request_energy_scan(bool steer);
+  void on_energy_scan(uint16_t count, esp_zb_energy_detect_channel_info_t *channel_info);
+  // Energy per channel, index 0 is channel 11. INT8_MIN if not scanned.
+  const int8_t *get_channel_energy() { return this->channel_energy_; }
+  uint32_t get_preferred_channel_mask() { return this->preferred_channel_mask_; }
+  bool energy_scan_on_boot_ = false;
+
+  void set_coex_policy(CoexPolicy policy, uint32_t window, uint32_t period) {
+    this->coex_policy_ = policy;
+    this->coex_window_ = window;
+    this->coex_period_ = period;
+  }
+  void request_tx_stats();
+  void on_tx_stats(const TxStats &stats);
+  TxStats get_tx_stats() {
+    portENTER_CRITICAL(&this->tx_stats_lock_);
+    TxStats stats = this->tx_stats_;
+    portEXIT_CRITICAL(&this->tx_stats_lock_);
+    stats.coex_boosts = this->coex_boosts_;
+    return stats;
+  }
+
+  // Handlers must be registered before setup(), the registry is read by the Zigbee task without locking
+  void add_command_handler(uint8_t endpoint, uint16_t cluster, uint8_t command, zb_command_handler_t handler) {
+    this->command_handlers_[{endpoint, cluster, command}].push_back(std::move(handler));
+  }
+  void set_sync_command_handler(uint8_t endpoint, uint16_t cluster, uint8_t command,
+                                zb_sync_command_handler_t handler) {
+    this->sync_command_handlers_[{endpoint, cluster, command}] = std::move(handler);
+  }
+  esp_err_t on_custom_command(const esp_zb_zcl_custom_cluster_command_message_t *message);
+  bool on_raw_custom_command(uint8_t bufid);
+  void handle_custom_command(esp_zb_zcl_cmd_info_t info, const uint8_t *data, uint8_t size, const ZBRxInfo &rx);
+
+  bool send_on_off(const ZBTarget &target, uint8_t command);
+  bool send_move_to_level(const ZBTarget &target, uint8_t level, uint16_t transition_time);
+  bool send_level_move(const ZBTarget &target, uint8_t mode, uint8_t rate);
+  bool send_level_step(const ZBTarget &target, uint8_t mode, uint8_t step_size, uint16_t transition_time);
+  bool send_move_to_color(const ZBTarget &target, uint16_t x, uint16_t y, uint16_t transition_time);
+  bool send_recall_scene(const ZBTarget &target, uint16_t group_id, uint8_t scene_id);
+  void handle_default_response(esp_zb_zcl_cmd_info_t info, uint8_t resp_to_cmd, uint8_t status);
+  bool read_attribute(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                      zb_attr_callback_t callback, uint8_t src_endpoint = 1);
+  bool write_attribute(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint8_t attr_type,
+                       void *value, zb_attr_callback_t callback, uint8_t src_endpoint = 1);
+  void handle_write_attribute_response(esp_zb_zcl_cmd_info_t info, uint8_t status, uint16_t attr_id);
+  ClientStats get_client_stats() { return this->client_stats_; }
+
+  // Group membership of local endpoints, kept in the APS group table of the stack
+  void add_groups_cluster(uint8_t endpoint_id) {
+    this->add_missing_cluster_(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_GROUPS);
+  }
+  void add_group_membership(uint8_t endpoint_id, uint16_t group) { this->groups_.push_back({endpoint_id, group}); }
+  bool add_group(uint8_t endpoint_id, uint16_t group);
+  bool remove_group(uint8_t endpoint_id, uint16_t group);
+  bool is_group_member(uint8_t endpoint_id, uint16_t group);
+  void apply_groups();  // runs in the Zigbee task
+
+  // Scenes capture the registered server attributes of an endpoint and are stored in NVS
+  void add_scenes_cluster(uint8_t endpoint_id) {
+    this->add_groups_cluster(endpoint_id);
+    this->add_missing_cluster_(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_SCENES);
+  }
+  esp_err_t on_store_scene(const esp_zb_zcl_store_scene_message_t *message);
+  esp_err_t on_recall_scene(const esp_zb_zcl_recall_scene_message_t *message);
+  void handle_scene_recall(uint8_t endpoint, const uint8_t *data, uint8_t size, const ZBRxInfo &rx);
+
+  // Mirror of the attributes reported by or read from remote devices, filled in the main loop
+  void set_mirror(uint8_t size, uint32_t ttl) {
+    this->mirror_size_ = size;
+    this->mirror_ttl_ = ttl;
+  }
+  // nullptr if the attribute was never received or is older than the ttl
+  const MirrorEntry *find_remote_attr(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id);
+  template<typename T>
+  optional<T> get_remote_attr(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id) {
+    const MirrorEntry *entry = this->find_remote_attr(address, endpoint, cluster, attr_id);
+    if (entry == nullptr) {
+      return {};
+    }
+    return entry->get<T>();
+  }
+  void set_command_timeout(uint32_t command_timeout) { this->command_timeout_ = command_timeout; }
+
+  // Attributes with restore_value are packed into one NVS blob, written at most once per persist interval
+  void set_persist_interval(uint32_t persist_interval) { this->persist_interval_ = persist_interval; }
+  void add_persisted_attr(uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id,
+                          uint8_t attr_type) {
+    this->persisted_attrs_.push_back({endpoint_id, cluster_id, role, attr_id, attr_type});
+  }
+  void schedule_persist();
+
+  // Zigbee task side of ZB_DEFER_LOGx, the messages are logged by loop()
+  template<typename... Args> void defer_log(ZBLogId id, int line, Args... args) {
+    this->deferred_log_.log(id, line, args...);
+    this->enable_loop_soon_any_context();
+  }
+  uint32_t get_persist_writes() { return this->persist_writes_; }
+  void on_shutdown() override;
 
   template<typename F> void add_on_join_callback(F &&callback) {
     this->on_join_callback_.add(std::forward<F>(callback));
   }
+  template<typename F> void add_on_energy_scan_callback(F &&callback) {
+    this->on_energy_scan_callback_.add(std::forward<F>(callback));
+  }
+  template<typename F> void add_on_tx_stats_callback(F &&callback) {
+    this->on_tx_stats_callback_.add(std::forward<F>(callback));
+  }
 
   bool is_started() { return this->started_; }
   bool is_connected() { return this->connected_; }
+  // esp_zb_lock_acquire() with the timeout used outside the Zigbee task, failures are counted
+  bool try_lock() {
+    if (esp_zb_lock_acquire(20 / portTICK_PERIOD_MS)) {
+      return true;
+    }
+    this->lock_timeouts_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  uint32_t get_lock_timeouts() const { return this->lock_timeouts_.load(std::memory_order_relaxed); }
+  const PipelineStats &get_pipeline_stats() const { return this->pipeline_stats_; }
+  void count_report_sent() { this->pipeline_stats_.reports_sent++; }
   bool connected_ = false;
   bool started_ = false;
   bool joined_ = false;
 
   CallbackManager<void()> on_join_callback_{};
+  CallbackManager<void()> on_energy_scan_callback_{};
+  CallbackManager<void()> on_tx_stats_callback_{};
   struct {
     std::string model;
     std::string manufacturer;
@@ -135,16 +468,128 @@ class ZigBeeComponent : public Component {
 #endif
 
  protected:
+  std::atomic<uint32_t> task_stack_free_{0};
   template<typename... Args> friend void enqueue_zb_event(Args... args);
+  ZBDeferredLog deferred_log_;
   esphome::LockFreeQueue<ZBEvent, MAX_ZB_QUEUE_SIZE> zb_events_;
   esphome::EventPool<ZBEvent, MAX_ZB_QUEUE_SIZE> zb_event_pool_;
   esp_zb_attribute_list_t *create_basic_cluster_();
+  void add_missing_cluster_(uint8_t endpoint_id, uint16_t cluster_id);
+#ifdef USE_ZIGBEE_TIME
+  void create_time_server_();
+  uint8_t time_server_endpoint_{0};
+#endif
+#ifdef USE_ZIGBEE_OTA
+  void create_ota_client_();
+  void stop_ota_();
+  ZigBeeOtaWriter ota_writer_;
+  uint8_t ota_endpoint_{0};
+  uint16_t ota_manufacturer_;
+  uint16_t ota_image_type_;
+  uint32_t ota_file_version_;
+  uint8_t ota_block_size_;
+  uint16_t ota_query_interval_;  // minutes
+  bool ota_reboot_{false};       // set by the Zigbee task, handled in loop()
+#endif
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+  void create_diagnostics_server_();
+  void add_diagnostics_attrs_(uint16_t cluster_id, const ZBDiagAttr *attrs, size_t count);
+  uint8_t diagnostics_endpoint_{0};
+  uint32_t diagnostics_interval_{60000};
+  uint16_t diagnostics_cluster_{0xFC00};  // custom cluster of the component counters
+#endif
+#ifdef USE_ZIGBEE_ATTR_STATS
+  void log_attribute_stats_(int level, uint8_t count);
+#endif
+#ifdef USE_ZIGBEE_FAST_PATH
+  std::vector<ZBFastOutput> fast_outputs_;
+  bool has_fast_output_(uint8_t endpoint, uint16_t cluster, uint16_t attr_id) const;
+  ZBLatencyStats fast_latency_{};  // written by the Zigbee task
+  portMUX_TYPE fast_latency_lock_ = portMUX_INITIALIZER_UNLOCKED;
+  ZBLatencyStats loop_latency_{};  // only attributes with a fast output, for comparison
+#endif
+#ifdef USE_ZIGBEE_INJECT
+  ZBEventInjector injector_;
+#endif
+#ifdef USE_ZIGBEE_BENCHMARK
+  ZBBenchmark benchmark_;
+#endif
+#ifdef USE_ZIGBEE_TRACE
+  size_t trace_size_{0};
+  ZBTraceRecorder trace_recorder_;
+  ZBTraceReplayer trace_replayer_;
+#endif
   template<typename T>
   void add_attr_(ZigBeeAttribute *attr, uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id,
                  uint8_t attr_type, uint8_t attr_access, T *value_p);
   std::map<uint8_t, std::tuple<esp_zb_ha_standard_devices_t, esp_zb_cluster_list_t *>> endpoint_list_;
   std::map<std::tuple<uint8_t, uint16_t, uint8_t>, esp_zb_attribute_list_t *> attribute_list_;
   std::map<std::tuple<uint8_t, uint16_t, uint8_t, uint16_t>, ZigBeeAttribute *> attributes_;
+  std::map<std::tuple<uint8_t, uint16_t, uint8_t>, std::vector<zb_command_handler_t>> command_handlers_;
+  std::map<std::tuple<uint8_t, uint16_t, uint8_t>, zb_sync_command_handler_t> sync_command_handlers_;
+  template<typename T, typename F>
+  bool send_client_cmd_(const ZBTarget &target, uint16_t cluster, uint8_t command, T *cmd_req, F send);
+  void expire_client_cmds_();
+  void arm_client_cmd_timer_(uint32_t delay);
+  bool client_cmd_timer_{false};
+  struct PendingCommand {
+    bool active;
+    uint8_t tsn;
+    uint16_t cluster;
+    uint8_t command;
+    uint32_t sent;
+  } pending_cmds_[8]{};
+  ClientStats client_stats_{};
+  uint32_t command_timeout_ = 3000;
+  struct AttrRequest {
+    bool active;
+    bool write;
+    uint8_t tsn;
+    uint16_t address;
+    uint8_t endpoint;
+    uint16_t cluster;
+    uint16_t attr_id;
+    uint32_t sent;
+    uint8_t waiters;
+    zb_attr_callback_t callbacks[MAX_ATTR_REQUEST_WAITERS];
+  } attr_requests_[MAX_ATTR_REQUESTS]{};
+  bool attr_request_timer_{false};
+  AttrRequest *find_free_attr_request_();
+  void start_attr_request_(AttrRequest *request, bool write, uint8_t tsn, uint16_t address, uint8_t endpoint,
+                           uint16_t cluster, uint16_t attr_id, zb_attr_callback_t &&callback);
+  bool handle_attr_read_response_(esp_zb_zcl_cmd_info_t info, esp_zb_zcl_read_attr_resp_variable_t *variables);
+  void finish_attr_request_(AttrRequest *request, uint8_t status, const esp_zb_zcl_attribute_t *attribute);
+  void expire_attr_requests_();
+  void arm_attr_request_timer_(uint32_t delay);
+  void update_mirror_(esp_zb_zcl_addr_t src_address, uint8_t endpoint, uint16_t cluster,
+                      const esp_zb_zcl_attribute_t &attribute);
+  static uint64_t mirror_key_(uint16_t address, uint8_t endpoint, uint16_t cluster, uint16_t attr_id) {
+    return (uint64_t) address << 40 | (uint64_t) endpoint << 32 | (uint32_t) cluster << 16 | attr_id;
+  }
+  std::vector<MirrorEntry> mirror_;
+  std::unordered_map<uint64_t, uint8_t> mirror_index_;  // key -> position in mirror_
+  uint8_t mirror_size_ = 16;
+  uint32_t mirror_ttl_ = 3600000;
+  static constexpr uint8_t MAX_IEEE_ADDRESSES = 32;
+  std::unordered_map<uint16_t, uint64_t> ieee_addresses_;
+  std::atomic<bool> ieee_addresses_stale_{false};
+  struct PersistedAttr {
+    uint8_t endpoint_id;
+    uint16_t cluster_id;
+    uint8_t role;
+    uint16_t attr_id;
+    uint8_t attr_type;
+  };
+  uint32_t persist_layout_hash_();
+  void restore_persisted_attrs_();
+  // shutdown waits for the Zigbee lock, there is no later retry
+  void save_persisted_attrs_(bool shutdown = false);
+  std::vector<PersistedAttr> persisted_attrs_;
+  std::vector<uint8_t> persisted_blob_;  // last blob restored or written, unchanged blobs are not written again
+  uint32_t persist_interval_ = 60000;
+  uint32_t persist_writes_ = 0;
+  bool persist_pending_ = false;
+  std::vector<std::pair<uint8_t, uint16_t>> groups_;  // configured (endpoint, group), joined after start
   esp_zb_ep_list_t *esp_zb_ep_list_ = esp_zb_ep_list_create();
   uint8_t ident_time_;
   bool custom_trust_center_key_ = false;
@@ -152,30 +597,106 @@ class ZigBeeComponent : public Component {
   uint16_t keep_alive_ = 3000;
   uint8_t trustkey_[16] = {0};
   uint8_t device_version_ = 0;
+  uint8_t max_children_ = MAX_CHILDREN;
+  uint16_t network_size_ = 0;  // 0: keep the stack defaults
+  uint16_t io_buffer_size_ = 0;
+  uint16_t scheduler_queue_size_ = 0;
+  uint16_t task_stack_size_ = 4096;
+  uint8_t task_priority_ = 24;
+  uint8_t energy_scan_duration_ = 3;
+  uint8_t preferred_channels_ = 4;
+  bool energy_scan_steer_ = false;   // start steering once the boot scan finished
+  std::atomic<bool> energy_scan_updated_{false};  // set by the Zigbee task, published in loop()
+  int8_t channel_energy_[16];
+  uint32_t preferred_channel_mask_ = ESP_ZB_PRIMARY_CHANNEL_MASK;
+  void setup_coex_();
+  void set_coex_zigbee_priority_(bool high);
+  CoexPolicy coex_policy_ = COEX_POLICY_BALANCED;
+  uint32_t coex_window_ = 100;
+  uint32_t coex_period_ = 1000;
+  uint32_t coex_boosts_ = 0;
+  uint32_t coex_last_failures_ = 0;
+  TxStats tx_stats_{};  // written by the Zigbee task
+  portMUX_TYPE tx_stats_lock_ = portMUX_INITIALIZER_UNLOCKED;
+  std::atomic<bool> tx_stats_updated_{false};  // set by the Zigbee task, published in loop()
+  std::atomic<bool> tx_stats_publish_{false};  // a request_tx_stats() is waiting for the result
+  bool poll_tx_stats_();
+  PipelineStats pipeline_stats_{};
+  std::atomic<uint32_t> lock_timeouts_{0};
 };
 
+extern ZigBeeComponent *global_zigbee;
 extern "C" void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct);
+esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message);
 extern "C" void zb_set_ed_node_descriptor(bool power_src, bool rx_on_when_idle, bool alloc_addr);
 
+template<typename T, typename F>
+bool ZigBeeComponent::send_client_cmd_(const ZBTarget &target, uint16_t cluster, uint8_t command, T *cmd_req,
+                                       F send) {
+  if (!this->connected_) {
+    ESP_LOGW(TAG, "Not connected, command 0x%02x to cluster 0x%04x not sent", command, cluster);
+    return false;
+  }
+  cmd_req->zcl_basic_cmd.src_endpoint = target.src_endpoint;
+  cmd_req->zcl_basic_cmd.dst_endpoint = target.dst_endpoint;
+  cmd_req->zcl_basic_cmd.dst_addr_u.addr_short = target.address;
+  cmd_req->address_mode = (esp_zb_zcl_address_mode_t) target.address_mode;
+  if (!this->try_lock()) {
+    ESP_LOGW(TAG, "Zigbee stack busy, command 0x%02x to cluster 0x%04x not sent", command, cluster);
+    return false;
+  }
+  uint8_t tsn = send(cmd_req);
+  esp_zb_lock_release();
+  this->client_stats_.sent++;
+  // Groups do not answer with a default response
+  if (target.address_mode == ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT) {
+    return true;
+  }
+  PendingCommand *slot = &this->pending_cmds_[0];
+  for (auto &pending : this->pending_cmds_) {
+    if (!pending.active) {
+      slot = &pending;
+      break;
+    }
+    if ((int32_t) (pending.sent - slot->sent) < 0) {
+      slot = &pending;  // oldest, overwritten if all slots are in use
+    }
+  }
+  if (slot->active) {
+    // still in time, so not a timeout, but its response can no longer be matched
+    ESP_LOGD(TAG, "Too many commands in flight, command 0x%02x (tsn %u) not tracked", slot->command, slot->tsn);
+  }
+  *slot = PendingCommand{true, tsn, cluster, command, millis()};
+  if (!this->client_cmd_timer_) {
+    this->arm_client_cmd_timer_(this->command_timeout_);
+  }
+  return true;
+}
+
 template<typename T>
 void ZigBeeComponent::add_attr(uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id,
-                               uint8_t attr_type, uint8_t attr_access, uint8_t max_size, T value) {
+                               uint8_t attr_type, uint8_t attr_access, uint16_t max_size, T value) {
   this->add_attr<T>(nullptr, endpoint_id, cluster_id, role, attr_id, attr_type, attr_access, max_size, value);
 }
 
 template<typename T>
 void ZigBeeComponent::add_attr(ZigBeeAttribute *attr, uint8_t endpoint_id, uint16_t cluster_id, uint8_t role,
-                               uint16_t attr_id, uint8_t attr_type, uint8_t attr_access, uint8_t max_size, T value) {
+                               uint16_t attr_id, uint8_t attr_type, uint8_t attr_access, uint16_t max_size,
+                               T value) {
   // The size byte of the zcl_str must be set to the maximum value,
   // even though the initial string may be shorter.
   if constexpr (std::is_same<T, std::string>::value) {
-    auto zcl_str = get_zcl_string(value.c_str(), max_size, true);
+    auto zcl_str = get_zcl_bytes(attr_type, value.data(), value.size(), max_size, true);
     add_attr_(attr, endpoint_id, cluster_id, role, attr_id, attr_type, attr_access, zcl_str);
     delete[] zcl_str;
   } else if constexpr (std::is_convertible<T, const char *>::value) {
-    auto zcl_str = get_zcl_string(value, max_size, true);
+    auto zcl_str = get_zcl_bytes(attr_type, value, strlen(value), max_size, true);
     add_attr_(attr, endpoint_id, cluster_id, role, attr_id, attr_type, attr_access, zcl_str);
     delete[] zcl_str;
+  } else if (zcl_fixed_size(attr_type) <= sizeof(uint64_t)) {
+    uint8_t value_buf[sizeof(uint64_t)] = {};
+    zcl_encode_value(attr_type, value, value_buf);
+    add_attr_(attr, endpoint_id, cluster_id, role, attr_id, attr_type, attr_access, value_buf);
   } else {
     add_attr_(attr, endpoint_id, cluster_id, role, attr_id, attr_type, attr_access, &value);
   }
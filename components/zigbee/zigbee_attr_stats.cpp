@@ -0,0 +1,49 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_ATTR_STATS
+#include <algorithm>
+#include <cinttypes>
+#include "esphome/core/log.h"
+#include "zigbee_attribute.h"
+
+namespace esphome {
+namespace zigbee {
+
+std::vector<ZigBeeAttribute *> ZigBeeComponent::get_busiest_attributes(uint8_t count) {
+  std::vector<ZigBeeAttribute *> busiest;
+  for (auto const &[key, attr] : this->attributes_) {
+    if (attr->get_stats().total() > 0) {
+      busiest.push_back(attr);
+    }
+  }
+  auto busier = [](ZigBeeAttribute *a, ZigBeeAttribute *b) { return a->get_stats().total() > b->get_stats().total(); };
+  if (count > 0 && count < busiest.size()) {
+    std::partial_sort(busiest.begin(), busiest.begin() + count, busiest.end(), busier);
+    busiest.resize(count);
+  } else {
+    std::sort(busiest.begin(), busiest.end(), busier);
+  }
+  return busiest;
+}
+
+void ZigBeeComponent::log_attribute_stats_(int level, uint8_t count) {
+  std::vector<ZigBeeAttribute *> busiest = this->get_busiest_attributes(count);
+  esp_log_printf_(level, TAG, __LINE__, "  Attribute Stats: %u of %u attributes updated", (unsigned) busiest.size(),
+                  (unsigned) this->attributes_.size());
+  uint32_t now = millis();
+  for (ZigBeeAttribute *attr : busiest) {
+    const ZBAttrStats &stats = attr->get_stats();
+    char age[12] = "never";
+    if (stats.updated != 0) {
+      snprintf(age, sizeof(age), "%us", stats.age(now));
+    }
+    esp_log_printf_(level, TAG, __LINE__,
+                    "    %u/0x%04X/0x%04X: set %u, suppressed %u, reported %u, received %u, lock failures %u, age %s",
+                    attr->endpoint_id(), attr->cluster_id(), attr->attr_id(), stats.sets_requested,
+                    stats.sets_suppressed, stats.reports_sent, stats.received, stats.lock_failures, age);
+  }
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
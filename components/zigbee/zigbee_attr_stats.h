@@ -0,0 +1,44 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_ATTR_STATS
+#include <cstdint>
+#include <limits>
+
+namespace esphome {
+namespace zigbee {
+
+// Traffic of a single attribute since boot, 12 bytes per attribute. The counters saturate, the update time wraps
+// after 18 hours.
+struct ZBAttrStats {
+  uint16_t sets_requested;   // set_attr() calls
+  uint16_t sets_suppressed;  // values replaced by a newer one before they were written
+  uint16_t reports_sent;
+  uint16_t received;  // values written by the network or reported by remote devices
+  uint16_t updated;   // seconds since boot of the last applied set, write or report, odd, 0 if never updated
+  uint8_t lock_failures;
+
+  template<typename T> static void count(T &counter) {
+    if (counter < std::numeric_limits<T>::max()) {
+      counter++;
+    }
+  }
+  // seconds since the last update, modulo 18 hours
+  uint16_t age(uint32_t now) const { return (uint16_t) (now / 1000) - this->updated; }
+  uint32_t total() const { return (uint32_t) this->sets_requested + this->reports_sent + this->received; }
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+
+#define ZB_ATTR_COUNT(counter) esphome::zigbee::ZBAttrStats::count(this->stats_.counter)
+#define ZB_ATTR_UPDATED() this->stats_.updated = (uint16_t) (millis() / 1000) | 1
+#else
+#define ZB_ATTR_COUNT(counter) \
+  do { \
+  } while (0)
+#define ZB_ATTR_UPDATED() \
+  do { \
+  } while (0)
+#endif
@@ -1,4 +1,6 @@
 #include "zigbee_attribute.h"
+#include <algorithm>
+#include <cstring>
 
 namespace esphome {
 namespace zigbee {
@@ -7,7 +9,7 @@ void ZigBeeAttribute::set_attr_() {
   if (!this->zb_->is_connected()) {
     return;
   }
-  if (esp_zb_lock_acquire(20 / portTICK_PERIOD_MS)) {
+  if (this->zb_->try_lock()) {
     esp_zb_zcl_status_t state = esp_zb_zcl_set_attribute_val(this->endpoint_id_, this->cluster_id_, this->role_,
                                                              this->attr_id_, this->value_p, false);
     if (this->force_report_) {
@@ -17,9 +19,16 @@ void ZigBeeAttribute::set_attr_() {
     // Check for error
     if (state != ESP_ZB_ZCL_STATUS_SUCCESS) {
       ESP_LOGE(TAG, "Setting attribute failed: %s", esp_err_to_name(state));
+    } else {
+      ZB_ATTR_UPDATED();
+      if (this->restore_) {
+        this->zb_->schedule_persist();
+      }
     }
     ESP_LOGD(TAG, "Attribute set!");
     esp_zb_lock_release();
+  } else {
+    ZB_ATTR_COUNT(lock_failures);
   }
 }
 
@@ -29,7 +38,7 @@ void ZigBeeAttribute::report_(bool has_lock) {
   if (!this->zb_->is_connected()) {
     return;
   }
-  if (has_lock or esp_zb_lock_acquire(20 / portTICK_PERIOD_MS)) {
+  if (has_lock or this->zb_->try_lock()) {
     esp_zb_zcl_report_attr_cmd_t cmd = {
         .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
         .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
@@ -43,10 +52,73 @@ void ZigBeeAttribute::report_(bool has_lock) {
 
     // cmd.cluster_role = reporting_info.cluster_role;
     esp_zb_zcl_report_attr_cmd_req(&cmd);
+    this->zb_->count_report_sent();
+    ZB_ATTR_COUNT(reports_sent);
     this->report_requested_ = false;
     if (!has_lock) {
       esp_zb_lock_release();
     }
+  } else {
+    ZB_ATTR_COUNT(lock_failures);
+  }
+}
+
+bool ZigBeeAttribute::add_report_listener_(const ReportFilter &filter, ZBListenerNode *listener) {
+  if (this->report_listeners_.size() >= MAX_REPORT_LISTENERS) {
+    ESP_LOGE(TAG, "Too many on_report listeners for attribute 0x%04x", this->attr_id_);
+    return false;
+  }
+  uint64_t bit = 1ULL << this->report_listeners_.size();
+  this->report_listeners_.push_back({listener, filter.endpoints});
+  if (filter.addresses.empty() && filter.ieee_addresses.empty()) {
+    this->any_source_listeners_ |= bit;
+    return true;
+  }
+  for (uint16_t address : filter.addresses) {
+    this->short_listeners_[address] |= bit;
+  }
+  for (uint64_t ieee_address : filter.ieee_addresses) {
+    this->ieee_listeners_[ieee_address] |= bit;
+  }
+  return true;
+}
+
+void ZigBeeAttribute::on_report(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint,
+                                const ZBRxInfo &rx) {
+  this->last_rx_ = rx;
+  ZB_ATTR_COUNT(received);
+  ZB_ATTR_UPDATED();
+  uint64_t matched = this->any_source_listeners_;
+  uint64_t ieee_address = 0;
+  bool has_ieee_address = false;
+  if (src_address.addr_type == ESP_ZB_ZCL_ADDR_TYPE_SHORT) {
+    auto it = this->short_listeners_.find(src_address.u.short_addr);
+    if (it != this->short_listeners_.end()) {
+      matched |= it->second;
+    }
+    if (!this->ieee_listeners_.empty()) {
+      has_ieee_address = this->zb_->get_ieee_address(src_address.u.short_addr, &ieee_address);
+    }
+  } else if (src_address.addr_type == ESP_ZB_ZCL_ADDR_TYPE_IEEE) {
+    memcpy(&ieee_address, src_address.u.ieee_addr, sizeof(ieee_address));
+    has_ieee_address = true;
+  }
+  if (has_ieee_address) {
+    auto it = this->ieee_listeners_.find(ieee_address);
+    if (it != this->ieee_listeners_.end()) {
+      matched |= it->second;
+    }
+  }
+  for (uint8_t i = 0; i < this->report_listeners_.size(); i++) {
+    const std::vector<uint8_t> &endpoints = this->report_listeners_[i].endpoints;
+    if ((matched & (1ULL << i)) != 0 && !endpoints.empty() &&
+        std::find(endpoints.begin(), endpoints.end(), src_endpoint) == endpoints.end()) {
+      matched &= ~(1ULL << i);
+    }
+  }
+  if (matched != 0 && this->dispatch_report_ != nullptr && attribute.data.type == this->attr_type_ &&
+      attribute.data.value) {
+    (this->*dispatch_report_)(attribute, matched, src_address, src_endpoint);
   }
 }
 
@@ -74,6 +146,11 @@ void ZigBeeAttribute::set_report(bool force) {
   this->force_report_ = force;
 }
 
+void ZigBeeAttribute::set_restore() {
+  this->restore_ = true;
+  this->zb_->add_persisted_attr(this->endpoint_id_, this->cluster_id_, this->role_, this->attr_id_, this->attr_type_);
+}
+
 void ZigBeeAttribute::report() {
   this->report_requested_ = true;
   this->enable_loop();
@@ -93,5 +170,31 @@ void ZigBeeAttribute::loop() {
   }
 }
 
+#ifdef USE_LIGHT
+bool LightBatch::active_ = false;
+std::vector<std::pair<light::LightState *, light::LightCall>> LightBatch::calls_;
+
+light::LightCall *LightBatch::get(light::LightState *device) {
+  if (!active_) {
+    return nullptr;
+  }
+  for (auto &[state, call] : calls_) {
+    if (state == device) {
+      return &call;
+    }
+  }
+  calls_.emplace_back(device, device->make_call());
+  return &calls_.back().second;
+}
+
+void LightBatch::end() {
+  active_ = false;
+  for (auto &[state, call] : calls_) {
+    call.perform();
+  }
+  calls_.clear();
+}
+#endif
+
 }  // namespace zigbee
 }  // namespace esphome
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "zigbee.h"
+#include "zigbee_attr_stats.h"
 #include "esp_zigbee_core.h"
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
@@ -28,8 +31,51 @@ namespace zigbee {
 
 #ifdef USE_LIGHT
 void set_light_color(uint8_t ep, light::LightCall *call, uint16_t value, bool is_x);
+
+// Collects the light changes of a scene recall, so each light is updated with a single call
+class LightBatch {
+ public:
+  static void begin() { active_ = true; }
+  static void end();
+  // nullptr if no batch is active
+  static light::LightCall *get(light::LightState *device);
+
+ protected:
+  static bool active_;
+  static std::vector<std::pair<light::LightState *, light::LightCall>> calls_;
+};
 #endif
 
+static constexpr uint8_t MAX_REPORT_LISTENERS = 64;  // on_report automations per attribute
+
+// Link of the listener list of an attribute. The listeners are created by the code generation and live forever, so
+// they are chained through this member and dispatching never allocates.
+class ZBListenerNode {
+ protected:
+  friend class ZigBeeAttribute;
+  ZBListenerNode *next_listener_{nullptr};
+};
+
+// Receives the values written to an attribute by the network, decoded once per event into the C++ type generated for
+// the ZCL type of the attribute. All value listeners of an attribute must use the same type.
+template<typename T> class ZBValueListener : public ZBListenerNode {
+ public:
+  virtual void on_value(const T &value) = 0;
+};
+
+// Receives the reports of a remote attribute, decoded once per report like ZBValueListener
+template<typename T> class ZBReportListener : public ZBListenerNode {
+ public:
+  virtual void on_report(const T &value, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) = 0;
+};
+
+// Sources accepted by an on_report listener. Empty lists match any source.
+struct ReportFilter {
+  std::vector<uint16_t> addresses;
+  std::vector<uint64_t> ieee_addresses;
+  std::vector<uint8_t> endpoints;
+};
+
 class ZigBeeAttribute : public Component {
  public:
   ZigBeeAttribute(ZigBeeComponent *parent, uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id,
@@ -44,42 +90,62 @@ class ZigBeeAttribute : public Component {
   // void dump_config() override;
   void loop() override;
 
-  template<typename T> void add_attr(uint8_t attr_access, uint8_t max_size, T value);
+  template<typename T> void add_attr(uint8_t attr_access, uint16_t max_size, T value);
   esp_zb_zcl_reporting_info_t get_reporting_info();
   void set_report(bool force);
+  void set_restore();
   void report();
   template<typename T> void set_attr(const T &value);
 
   uint8_t attr_type() { return attr_type_; }
+  uint8_t endpoint_id() const { return this->endpoint_id_; }
+  uint16_t cluster_id() const { return this->cluster_id_; }
+  uint16_t attr_id() const { return this->attr_id_; }
+#ifdef USE_ZIGBEE_ATTR_STATS
+  const ZBAttrStats &get_stats() const { return this->stats_; }
+#endif
 
-  template<typename F> void add_on_value_callback(F &&callback) { on_value_callback_.add(std::forward<F>(callback)); }
-  void on_value(esp_zb_zcl_attribute_t attribute) { this->on_value_callback_.call(attribute); }
-
-  void add_on_report_callback(
-      std::function<void(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint)>
-          callback) {
-    on_report_callback_.add(std::move(callback));
+  // Listeners are called in the order they were added
+  template<typename T> void add_value_listener(ZBValueListener<T> *listener);
+  void on_value(esp_zb_zcl_attribute_t attribute, const ZBRxInfo &rx) {
+    this->last_rx_ = rx;
+    ZB_ATTR_COUNT(received);
+    ZB_ATTR_UPDATED();
+    if (this->restore_) {
+      this->zb_->schedule_persist();
+    }
+    if (this->dispatch_value_ != nullptr && attribute.data.type == this->attr_type_ && attribute.data.value) {
+      (this->*dispatch_value_)(attribute);
+    }
   }
-  void on_report(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) {
-    this->on_report_callback_.call(attribute, src_address, src_endpoint);
+  // Reception metadata of the last value or report, valid while the callbacks run
+  const ZBRxInfo &last_rx() const { return this->last_rx_; }
+
+  template<typename T> void add_report_listener(const ReportFilter &filter, ZBReportListener<T> *listener) {
+    if (this->add_report_listener_(filter, listener)) {
+      this->dispatch_report_ = &ZigBeeAttribute::dispatch_report_typed_<T>;
+    }
   }
+  // Only the listeners whose filter matches the source are called
+  void on_report(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint,
+                 const ZBRxInfo &rx);
   bool report_enabled = false;
 
 #ifdef USE_SENSOR
   template<typename T> void connect(sensor::Sensor *sensor);
-  template<typename T> void connect(sensor::Sensor *sensor, std::function<T(float)> &&f);
+  template<typename T, typename F> void connect(sensor::Sensor *sensor, F &&f);
 #endif
 #ifdef USE_BINARY_SENSOR
   template<typename T> void connect(binary_sensor::BinarySensor *sensor);
-  template<typename T> void connect(binary_sensor::BinarySensor *sensor, std::function<T(bool)> &&f);
+  template<typename T, typename F> void connect(binary_sensor::BinarySensor *sensor, F &&f);
 #endif
 #ifdef USE_TEXT_SENSOR
   template<typename T> void connect(text_sensor::TextSensor *sensor);
-  template<typename T> void connect(text_sensor::TextSensor *sensor, std::function<T(std::string)> &&f);
+  template<typename T, typename F> void connect(text_sensor::TextSensor *sensor, F &&f);
 #endif
 #ifdef USE_SWITCH
   template<typename T> void connect(switch_::Switch *device);
-  template<typename T> void connect(switch_::Switch *device, std::function<bool(T)> &&f);
+  template<typename T, typename F> void connect(switch_::Switch *device, F &&f);
 #endif
 #ifdef USE_LIGHT
   template<typename T> void connect(light::LightState *device);
@@ -89,24 +155,46 @@ class ZigBeeAttribute : public Component {
   void set_attr_();
   void report_();
   void report_(bool has_lock);
+  bool add_report_listener_(const ReportFilter &filter, ZBListenerNode *listener);
+  template<typename T> void dispatch_value_typed_(const esp_zb_zcl_attribute_t &attribute);
+  template<typename T>
+  void dispatch_report_typed_(const esp_zb_zcl_attribute_t &attribute, uint64_t listeners,
+                              esp_zb_zcl_addr_t src_address, uint8_t src_endpoint);
   ZigBeeComponent *zb_;
   uint8_t endpoint_id_;
   uint16_t cluster_id_;
   uint8_t role_;
   uint16_t attr_id_;
+  uint16_t max_size_;  // capacity of string and array values
   uint8_t attr_type_;
-  uint8_t max_size_;
   float scale_;
-  CallbackManager<void(esp_zb_zcl_attribute_t attribute)> on_value_callback_{};
-  CallbackManager<void(esp_zb_zcl_attribute_t attribute, esp_zb_zcl_addr_t src_address, uint8_t src_endpoint)>
-      on_report_callback_{};
+  ZBListenerNode *value_listeners_{nullptr};
+  // Decodes the value into the type of the listeners and calls them, set by the first listener
+  void (ZigBeeAttribute::*dispatch_value_)(const esp_zb_zcl_attribute_t &attribute){nullptr};
+  void (ZigBeeAttribute::*dispatch_report_)(const esp_zb_zcl_attribute_t &attribute, uint64_t listeners,
+                                            esp_zb_zcl_addr_t src_address, uint8_t src_endpoint){nullptr};
+  struct ReportListener {
+    ZBListenerNode *listener;
+    std::vector<uint8_t> endpoints;
+  };
+  std::vector<ReportListener> report_listeners_;
+  // Bitmasks of report_listeners_ indices
+  uint64_t any_source_listeners_{0};
+  std::unordered_map<uint16_t, uint64_t> short_listeners_;
+  std::unordered_map<uint64_t, uint64_t> ieee_listeners_;
+  ZBRxInfo last_rx_{};
   void *value_p{nullptr};
+  uint8_t value_buf_[8]{};  // encoded value of fixed size types
   bool set_attr_requested_{false};
   bool report_requested_{false};
   bool force_report_{false};
+  bool restore_{false};
+#ifdef USE_ZIGBEE_ATTR_STATS
+  ZBAttrStats stats_{};
+#endif
 };
 
-template<typename T> void ZigBeeAttribute::add_attr(uint8_t attr_access, uint8_t max_size, T value) {
+template<typename T> void ZigBeeAttribute::add_attr(uint8_t attr_access, uint16_t max_size, T value) {
   this->max_size_ = max_size;
   this->zb_->add_attr(this, this->endpoint_id_, this->cluster_id_, this->role_, this->attr_id_, this->attr_type_,
                       attr_access, max_size, std::move(value));
@@ -114,38 +202,68 @@ template<typename T> void ZigBeeAttribute::add_attr(uint8_t attr_access, uint8_t
 
 template<typename T> void ZigBeeAttribute::set_attr(const T &value) {
   if constexpr (std::is_convertible<T, const char *>::value) {
-    auto zcl_str = get_zcl_string(value, this->max_size_);
+    auto zcl_str = get_zcl_bytes(this->attr_type_, value, strlen(value), this->max_size_);
 
     if (this->value_p != nullptr) {
       delete[](char *) this->value_p;
     }
     this->value_p = (void *) zcl_str;
   } else if constexpr (std::is_same<T, std::string>::value) {
-    auto zcl_str = get_zcl_string(value.c_str(), this->max_size_);
+    auto zcl_str = get_zcl_bytes(this->attr_type_, value.data(), value.size(), this->max_size_);
 
     if (this->value_p != nullptr) {
       delete[](char *) this->value_p;
     }
     this->value_p = (void *) zcl_str;
   } else {
-    if (this->value_p != nullptr) {
-      delete (T *) this->value_p;
-    }
-    T *value_p = new T;
-    *value_p = value;
-    this->value_p = (void *) value_p;
+    // in the width of the attribute type, e.g. 6 bytes for U48 or a half float for SEMI
+    zcl_encode_value(this->attr_type_, value, this->value_buf_);
+    this->value_p = this->value_buf_;
+  }
+  ZB_ATTR_COUNT(sets_requested);
+  if (this->set_attr_requested_) {
+    ZB_ATTR_COUNT(sets_suppressed);
   }
   this->set_attr_requested_ = true;
   this->enable_loop();
 }
 
+template<typename T> void ZigBeeAttribute::add_value_listener(ZBValueListener<T> *listener) {
+  this->dispatch_value_ = &ZigBeeAttribute::dispatch_value_typed_<T>;
+  ZBListenerNode **tail = &this->value_listeners_;
+  while (*tail != nullptr) {
+    tail = &(*tail)->next_listener_;
+  }
+  *tail = listener;
+}
+
+template<typename T> void ZigBeeAttribute::dispatch_value_typed_(const esp_zb_zcl_attribute_t &attribute) {
+  const T value = get_value_by_type<T>(this->attr_type_, attribute.data.value);
+  for (ZBListenerNode *node = this->value_listeners_; node != nullptr; node = node->next_listener_) {
+    static_cast<ZBValueListener<T> *>(node)->on_value(value);
+  }
+}
+
+template<typename T>
+void ZigBeeAttribute::dispatch_report_typed_(const esp_zb_zcl_attribute_t &attribute, uint64_t listeners,
+                                             esp_zb_zcl_addr_t src_address, uint8_t src_endpoint) {
+  const T value = get_value_by_type<T>(this->attr_type_, attribute.data.value);
+  for (uint8_t i = 0; listeners != 0; i++, listeners >>= 1) {
+    if ((listeners & 1) != 0) {
+      static_cast<ZBReportListener<T> *>(this->report_listeners_[i].listener)->on_report(value, src_address,
+                                                                                         src_endpoint);
+    }
+  }
+}
+
 #ifdef USE_SENSOR
 template<typename T> void ZigBeeAttribute::connect(sensor::Sensor *sensor) {
   sensor->add_on_state_callback([=, this](float value) { this->set_attr((T) (this->scale_ * value)); });
 }
 
-template<typename T> void ZigBeeAttribute::connect(sensor::Sensor *sensor, std::function<T(float)> &&f) {
-  sensor->add_on_state_callback([=, this](float value) { this->set_attr(f(value)); });
+// The lambdas of the code generation are taken as they are, without wrapping them in a std::function
+template<typename T, typename F> void ZigBeeAttribute::connect(sensor::Sensor *sensor, F &&f) {
+  sensor->add_on_state_callback([f = std::forward<F>(f), this](float value) { this->set_attr<T>(f(value)); });
 }
 #endif
 
@@ -154,8 +272,8 @@ template<typename T> void ZigBeeAttribute::connect(binary_sensor::BinarySensor *
   sensor->add_on_state_callback([=, this](bool value) { this->set_attr((T) (this->scale_ * value)); });
 }
 
-template<typename T> void ZigBeeAttribute::connect(binary_sensor::BinarySensor *sensor, std::function<T(bool)> &&f) {
-  sensor->add_on_state_callback([=, this](bool value) { this->set_attr(f(value)); });
+template<typename T, typename F> void ZigBeeAttribute::connect(binary_sensor::BinarySensor *sensor, F &&f) {
+  sensor->add_on_state_callback([f = std::forward<F>(f), this](bool value) { this->set_attr<T>(f(value)); });
 }
 #endif
 
@@ -164,68 +282,81 @@ template<typename T> void ZigBeeAttribute::connect(text_sensor::TextSensor *sens
   sensor->add_on_state_callback([=, this](std::string value) { this->set_attr((T) (value)); });
 }
 
-template<typename T> void ZigBeeAttribute::connect(text_sensor::TextSensor *sensor, std::function<T(std::string)> &&f) {
-  sensor->add_on_state_callback([=, this](std::string value) { this->set_attr(f(value)); });
+template<typename T, typename F> void ZigBeeAttribute::connect(text_sensor::TextSensor *sensor, F &&f) {
+  sensor->add_on_state_callback([f = std::forward<F>(f), this](std::string value) { this->set_attr<T>(f(value)); });
 }
 #endif
 
 #ifdef USE_SWITCH
-template<typename T> void ZigBeeAttribute::connect(switch_::Switch *device) {
-  this->add_on_value_callback([=, this](esp_zb_zcl_attribute_t attribute) {
-    if (attribute.data.type == this->attr_type() && attribute.data.value) {
-      if (get_value_by_type<T>(this->attr_type(), attribute.data.value)) {
-        device->turn_on();
-      } else {
-        device->turn_off();
-      }
+// F maps the written value to the switch state, stored by value so dispatching calls it directly
+template<typename T, typename F> class ZBSwitchListener : public ZBValueListener<T> {
+ public:
+  ZBSwitchListener(switch_::Switch *device, F f) : device_(device), f_(std::move(f)) {}
+  void on_value(const T &value) override {
+    if (this->f_(value)) {
+      this->device_->turn_on();
+    } else {
+      this->device_->turn_off();
     }
-  });
+  }
+
+ protected:
+  switch_::Switch *device_;
+  F f_;
+};
+
+template<typename T> void ZigBeeAttribute::connect(switch_::Switch *device) {
+  auto to_state = [](const T &value) { return static_cast<bool>(value); };
+  this->add_value_listener<T>(new ZBSwitchListener<T, decltype(to_state)>(device, to_state));
   device->add_on_state_callback([=, this](bool value) { this->set_attr((T) (this->scale_ * value)); });
 }
 
-template<typename T> void ZigBeeAttribute::connect(switch_::Switch *device, std::function<bool(T)> &&f) {
-  this->add_on_value_callback([=, this](esp_zb_zcl_attribute_t attribute) {
-    if (attribute.data.type == this->attr_type() && attribute.data.value) {
-      if (f(get_value_by_type<T>(this->attr_type(), attribute.data.value))) {
-        device->turn_on();
-      } else {
-        device->turn_off();
-      }
-    }
-  });
+template<typename T, typename F> void ZigBeeAttribute::connect(switch_::Switch *device, F &&f) {
+  this->add_value_listener<T>(new ZBSwitchListener<T, std::decay_t<F>>(device, std::forward<F>(f)));
 }
 #endif
 
 #ifdef USE_LIGHT
-template<typename T> void ZigBeeAttribute::connect(light::LightState *device) {
-  this->add_on_value_callback([=, this](esp_zb_zcl_attribute_t attribute) {
-    if (attribute.data.type == this->attr_type() && attribute.data.value) {
-      light::LightCall call = device->make_call();
-      ESP_LOGD(TAG, "Make light call");
-      if (std::is_same<T, bool>::value) {
-        call.set_state(get_value_by_type<T>(this->attr_type(), attribute.data.value));
-        ESP_LOGD(TAG, "Set state");
-      } else if (this->cluster_id_ == 0x0300 && this->attr_id_ == 0x3) {
-        // set X
-        set_light_color(this->endpoint_id_, &call, get_value_by_type<uint16_t>(this->attr_type(), attribute.data.value),
-                        true);
-        ESP_LOGD(TAG, "Set X");
-      } else if (this->cluster_id_ == 0x0300 && this->attr_id_ == 0x4) {
-        // set Y
-        set_light_color(this->endpoint_id_, &call, get_value_by_type<uint16_t>(this->attr_type(), attribute.data.value),
-                        false);
-        ESP_LOGD(TAG, "Set Y");
-      } else if (this->cluster_id_ != 0x0300 and std::numeric_limits<T>::is_integer) {
-        call.set_brightness((float) get_value_by_type<T>(this->attr_type(), attribute.data.value) /
-                            255);  // integer level between 0 and 255
-        ESP_LOGD(TAG, "Set level: %f", (float) get_value_by_type<T>(this->attr_type(), attribute.data.value) / 255);
-        //} else if (this->cluster_id_ != 0x0300 and std::is_floating_point<T>) {
-        //  call.set_brightness(get_value_by_type<T>(this->attr_type(), attribute.data.value));  //float level between 0
-        //  and 1
-      }
+template<typename T> class ZBLightListener : public ZBValueListener<T> {
+ public:
+  ZBLightListener(light::LightState *device, uint8_t endpoint_id, uint16_t cluster_id, uint16_t attr_id)
+      : device_(device), endpoint_id_(endpoint_id), cluster_id_(cluster_id), attr_id_(attr_id) {}
+  void on_value(const T &value) override {
+    light::LightCall local_call = this->device_->make_call();
+    light::LightCall *batched = LightBatch::get(this->device_);
+    light::LightCall &call = batched != nullptr ? *batched : local_call;
+    ESP_LOGD(TAG, "Make light call");
+    if (std::is_same<T, bool>::value) {
+      call.set_state(value);
+      ESP_LOGD(TAG, "Set state");
+    } else if (this->cluster_id_ == 0x0300 && this->attr_id_ == 0x3) {
+      // set X
+      set_light_color(this->endpoint_id_, &call, (uint16_t) value, true);
+      ESP_LOGD(TAG, "Set X");
+    } else if (this->cluster_id_ == 0x0300 && this->attr_id_ == 0x4) {
+      // set Y
+      set_light_color(this->endpoint_id_, &call, (uint16_t) value, false);
+      ESP_LOGD(TAG, "Set Y");
+    } else if (this->cluster_id_ != 0x0300 and std::numeric_limits<T>::is_integer) {
+      call.set_brightness((float) value / 255);  // integer level between 0 and 255
+      ESP_LOGD(TAG, "Set level: %f", (float) value / 255);
+      //} else if (this->cluster_id_ != 0x0300 and std::is_floating_point<T>) {
+      //  call.set_brightness(value);  //float level between 0 and 1
+    }
+    if (batched == nullptr) {
       call.perform();
     }
-  });
+  }
+
+ protected:
+  light::LightState *device_;
+  uint8_t endpoint_id_;
+  uint16_t cluster_id_;
+  uint16_t attr_id_;
+};
+
+template<typename T> void ZigBeeAttribute::connect(light::LightState *device) {
+  this->add_value_listener<T>(new ZBLightListener<T>(device, this->endpoint_id_, this->cluster_id_, this->attr_id_));
 }
 #endif
 
@@ -0,0 +1,139 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_BENCHMARK
+#include <algorithm>
+#include <cinttypes>
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+static const char *const INJECT_EVENT_NAMES[] = {"set_attr", "report_attr", "read_resp"};
+
+bool ZBBenchmark::start(ZBEventInjector *injector, Component *parent, const ZBBenchmarkConfig &config) {
+  if (this->running_ || injector->is_running()) {
+    ESP_LOGW(TAG, "Benchmark or event injection already running");
+    return false;
+  }
+  if (config.count == 0 || config.events.empty() || config.payloads.empty() || config.rates.empty() ||
+      config.costs.empty()) {
+    return false;
+  }
+  this->injector_ = injector;
+  this->parent_ = parent;
+  this->config_ = config;
+  this->config_.count = std::min(config.count, MAX_BENCHMARK_EVENTS);
+  this->latencies_.reserve(this->config_.count);
+  this->runs_ = config.events.size() * config.payloads.size() * config.rates.size() * config.costs.size();
+  this->index_ = 0;
+  ESP_LOGI(TAG, "Benchmark: %" PRIu32 " runs of %" PRIu32 " events, queue size %u", this->runs_,
+           this->config_.count, MAX_ZB_QUEUE_SIZE);
+  this->running_ = true;
+  if (!this->start_run_()) {
+    this->running_ = false;
+    std::vector<uint32_t>().swap(this->latencies_);
+    return false;
+  }
+  return true;
+}
+
+bool ZBBenchmark::start_run_() {
+  // the consumer cost changes fastest, the event type slowest
+  uint32_t i = this->index_;
+  this->cost_ = this->config_.costs[i % this->config_.costs.size()];
+  i /= this->config_.costs.size();
+  uint32_t rate = this->config_.rates[i % this->config_.rates.size()];
+  i /= this->config_.rates.size();
+  const ZBBenchmarkPayload &payload = this->config_.payloads[i % this->config_.payloads.size()];
+  i /= this->config_.payloads.size();
+  this->run_.event = this->config_.events[i];
+  this->run_.count = this->config_.count;
+  this->run_.rate = rate;
+  this->run_.endpoint = this->config_.endpoint;
+  this->run_.cluster = this->config_.cluster;
+  this->run_.attr_id = this->config_.attr_id;
+  this->run_.attr_type = payload.attr_type;
+  this->run_.size = payload.size;
+  this->injected_ = false;
+  this->dispatched_ = 0;
+  this->dropped_ = 0;
+  this->full_ = 0;
+  this->batch_ = 0;
+  this->peak_batch_ = 0;
+  this->latencies_.clear();
+  this->start_ = micros();
+  this->last_dispatch_ = this->start_;
+  return this->injector_->start(this->parent_, this->run_);
+}
+
+void ZBBenchmark::on_dispatch(uint32_t queued, uint32_t dequeued) {
+  if (!this->running_) {
+    return;
+  }
+  // the handlers are not part of the queue latency
+  if (this->latencies_.size() < this->latencies_.capacity()) {
+    this->latencies_.push_back(dequeued - queued);
+  }
+  this->dispatched_++;
+  this->batch_++;
+  if (this->cost_ > 0) {
+    delayMicroseconds(this->cost_);  // work done by triggers and components
+  }
+  this->last_dispatch_ = micros();
+}
+
+void ZBBenchmark::loop() {
+  if (!this->running_) {
+    return;
+  }
+  if (this->batch_ >= MAX_ZB_QUEUE_SIZE) {
+    this->full_++;
+  }
+  this->peak_batch_ = std::max(this->peak_batch_, this->batch_);
+  this->batch_ = 0;
+  if (this->injector_->take_finished()) {
+    this->injected_ = true;
+  }
+  // wait for the events still in the queue
+  if (!this->injected_ || this->dispatched_ + this->dropped_ < this->injector_->get_result().injected) {
+    return;
+  }
+  this->log_run_();
+  this->index_++;
+  if (this->index_ < this->runs_ && this->start_run_()) {
+    return;
+  }
+  if (this->index_ < this->runs_) {
+    ESP_LOGW(TAG, "Benchmark aborted after %" PRIu32 " runs", this->index_);
+  } else {
+    ESP_LOGI(TAG, "Benchmark finished");
+  }
+  this->running_ = false;
+  std::vector<uint32_t>().swap(this->latencies_);
+}
+
+uint32_t ZBBenchmark::percentile_(uint8_t p) const {
+  if (this->latencies_.empty()) {
+    return 0;
+  }
+  return this->latencies_[(this->latencies_.size() - 1) * p / 100];
+}
+
+void ZBBenchmark::log_run_() {
+  std::sort(this->latencies_.begin(), this->latencies_.end());
+  uint32_t elapsed = this->last_dispatch_ - this->start_;
+  float throughput = elapsed > 0 ? this->dispatched_ * 1e6f / elapsed : 0.0f;
+  const ZBInjectResult &result = this->injector_->get_result();
+  // fixed columns, runs of different builds can be compared line by line
+  ESP_LOGI(TAG,
+           "bench %-11s type=0x%02X size=%3u rate=%6" PRIu32 " cost=%5" PRIu32 "us: %8.1f ev/s p50=%6" PRIu32
+           "us p99=%6" PRIu32 "us max=%6" PRIu32 "us dropped=%" PRIu32 " full=%" PRIu32 " peak=%u rejected=%" PRIu32,
+           INJECT_EVENT_NAMES[this->run_.event], this->run_.attr_type, this->run_.size, this->run_.rate, this->cost_,
+           throughput, this->percentile_(50), this->percentile_(99), this->percentile_(100), this->dropped_,
+           this->full_, this->peak_batch_, result.rejected);
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_BENCHMARK
+#include <vector>
+#include "zigbee_inject.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr uint32_t MAX_BENCHMARK_EVENTS = 2000;  // latencies of one run are kept for exact percentiles
+
+struct ZBBenchmarkPayload {
+  uint8_t attr_type;
+  uint16_t size;
+};
+
+struct ZBBenchmarkConfig {
+  uint32_t count;  // events per run
+  uint8_t endpoint;
+  uint16_t cluster;
+  uint16_t attr_id;
+  std::vector<ZBInjectEvent> events;
+  std::vector<ZBBenchmarkPayload> payloads;
+  std::vector<uint32_t> rates;
+  std::vector<uint32_t> costs;  // busy time of the main loop per dispatched event in us
+};
+
+// Runs the injector over every combination of event, payload, rate and consumer cost and logs one line per run
+// with the throughput, the enqueue to dispatch latency, pool exhaustion and drops.
+class ZBBenchmark {
+ public:
+  bool start(ZBEventInjector *injector, Component *parent, const ZBBenchmarkConfig &config);
+  bool is_running() const { return this->running_; }
+  // Called in the main loop for every dispatched event, before the event is released. queued and dequeued are micros()
+  // when the Zigbee task queued the event and when the main loop took it from the queue.
+  void on_dispatch(uint32_t queued, uint32_t dequeued);
+  // Events dropped because the pool was empty
+  void add_dropped(uint16_t dropped) { this->dropped_ += dropped; }
+  // Called in the main loop after the queue was drained, completes the run and starts the next one
+  void loop();
+
+ protected:
+  bool start_run_();
+  void log_run_();
+  uint32_t percentile_(uint8_t p) const;
+
+  ZBEventInjector *injector_{nullptr};
+  Component *parent_{nullptr};
+  ZBBenchmarkConfig config_{};
+  ZBInjectConfig run_{};
+  bool running_{false};
+  bool injected_{false};  // the injector finished the current run
+  uint32_t index_{0};
+  uint32_t runs_{0};
+  uint32_t cost_{0};
+  uint32_t start_{0};  // micros()
+  uint32_t last_dispatch_{0};
+  uint32_t dispatched_{0};
+  uint32_t dropped_{0};
+  uint32_t full_{0};  // loop passes that found every pool event in the queue
+  uint16_t batch_{0};
+  uint16_t peak_batch_{0};
+  std::vector<uint32_t> latencies_;
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
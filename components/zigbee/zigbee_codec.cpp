@@ -0,0 +1,26 @@
+#include "zigbee_codec.h"
+#include <algorithm>
+
+namespace esphome {
+namespace zigbee {
+
+uint8_t *get_zcl_bytes(uint8_t type, const void *data, size_t size, uint16_t max_size, bool use_max_size) {
+  uint8_t prefix = std::max<uint8_t>(zcl_length_prefix(type), 1);
+  if (prefix == 1) {
+    max_size = std::min<uint16_t>(max_size, 0xFE);  // 0xFF is the invalid length of short strings
+  }
+  uint16_t length = std::min<size_t>(size, max_size);
+  uint16_t zcl_size = use_max_size ? max_size : length;
+
+  uint8_t *zcl_str = new uint8_t[prefix + zcl_size]();  // length (little endian) + content
+  zcl_str[0] = zcl_size & 0xFF;
+  if (prefix == 2) {
+    zcl_str[1] = zcl_size >> 8;
+  }
+  memcpy(zcl_str + prefix, data, length);
+
+  return zcl_str;
+}
+
+}  // namespace zigbee
+}  // namespace esphome
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "esp_zigbee_core.h"
+
+namespace esphome {
+namespace zigbee {
+
+// Encoding and decoding of ZCL attribute values. Values are little endian like on air, the integer types of
+// 24 to 56 bits are stored in their exact width. Strings and arrays start with a length of 1 (short strings)
+// or 2 bytes (long strings and arrays).
+
+// Size of the numeric ZCL types, 0 for strings and other variable length types. The low 3 bits of the integer,
+// bitmap and data types encode the size - 1.
+inline uint8_t zcl_numeric_size(uint8_t type) {
+  if ((type >= ESP_ZB_ZCL_ATTR_TYPE_8BIT && type <= ESP_ZB_ZCL_ATTR_TYPE_64BIT) ||
+      (type >= ESP_ZB_ZCL_ATTR_TYPE_8BITMAP && type <= ESP_ZB_ZCL_ATTR_TYPE_U64) ||
+      (type >= ESP_ZB_ZCL_ATTR_TYPE_S8 && type <= ESP_ZB_ZCL_ATTR_TYPE_S64)) {
+    return (type & 0x07) + 1;
+  }
+  switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+      return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
+    case ESP_ZB_ZCL_ATTR_TYPE_SEMI:
+    case ESP_ZB_ZCL_ATTR_TYPE_CLUSTER_ID:
+    case ESP_ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID:
+      return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_SINGLE:
+    case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
+      return 4;
+    case ESP_ZB_ZCL_ATTR_TYPE_DOUBLE:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+// Size of all fixed size types, including the time, identifier and key types
+inline uint8_t zcl_fixed_size(uint8_t type) {
+  switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
+    case ESP_ZB_ZCL_ATTR_TYPE_DATE:
+    case ESP_ZB_ZCL_ATTR_TYPE_BACNET_OID:
+      return 4;
+    case ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR:
+      return 8;
+    case ESP_ZB_ZCL_ATTR_TYPE_128_BIT_KEY:
+      return 16;
+    default:
+      return zcl_numeric_size(type);
+  }
+}
+
+// Size of the length in front of strings and arrays, 0 for fixed size types
+inline uint8_t zcl_length_prefix(uint8_t type) {
+  switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
+      return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_ARRAY:
+    case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ARRAY:
+    case ESP_ZB_ZCL_ATTR_TYPE_32BIT_ARRAY:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+inline bool zcl_is_signed(uint8_t type) { return type >= ESP_ZB_ZCL_ATTR_TYPE_S8 && type <= ESP_ZB_ZCL_ATTR_TYPE_S64; }
+
+// Content of a string or array value without copying, empty for fixed size types and invalid (0xFF/0xFFFF) lengths
+struct ZBBytesView {
+  const uint8_t *data;
+  uint16_t size;
+};
+
+inline ZBBytesView zcl_bytes_view(uint8_t type, const void *value) {
+  const uint8_t *data = (const uint8_t *) value;
+  uint8_t prefix = zcl_length_prefix(type);
+  if (data == nullptr || prefix == 0) {
+    return {nullptr, 0};
+  }
+  uint16_t size = prefix == 1 ? data[0] : (uint16_t) (data[0] | data[1] << 8);
+  if (size == (prefix == 1 ? 0xFF : 0xFFFF)) {
+    return {data + prefix, 0};
+  }
+  return {data + prefix, size};
+}
+
+// Bytes used by the value including the length of strings and arrays, 0 for unknown types. With the size of the
+// buffer holding value (esp_zb_zcl_attribute_data_t::size, 0 if unknown) a length beyond the buffer is clamped.
+inline size_t zcl_value_size(uint8_t type, const void *value, size_t buffer_size = 0) {
+  uint8_t prefix = zcl_length_prefix(type);
+  if (prefix == 0) {
+    return zcl_fixed_size(type);
+  }
+  if (value == nullptr) {
+    return 0;
+  }
+  if (buffer_size != 0 && buffer_size < prefix) {
+    return buffer_size;  // not even the length fits
+  }
+  size_t size = prefix + zcl_bytes_view(type, value).size;
+  return buffer_size != 0 && buffer_size < size ? buffer_size : size;
+}
+
+// Copies size bytes as returned by zcl_value_size, the length of a clamped string or array is shortened to the
+// copied content. out must hold at least the length prefix.
+inline void zcl_copy_value(uint8_t type, uint8_t *out, const void *value, size_t size) {
+  memcpy(out, value, size);
+  uint8_t prefix = zcl_length_prefix(type);
+  if (prefix == 0) {
+    return;
+  }
+  uint16_t length = size > prefix ? size - prefix : 0;
+  if (size < prefix || zcl_bytes_view(type, out).size > length) {
+    out[0] = length & 0xFF;
+    if (prefix == 2) {
+      out[1] = length >> 8;
+    }
+  }
+}
+
+inline uint64_t zcl_read_unsigned(const uint8_t *data, uint8_t size) {
+  uint64_t raw = 0;
+  memcpy(&raw, data, size);  // the chip is little endian like the ZCL encoding
+  return raw;
+}
+
+inline int64_t zcl_read_signed(const uint8_t *data, uint8_t size) {
+  uint8_t shift = 64 - 8 * size;
+  return (int64_t) (zcl_read_unsigned(data, size) << shift) >> shift;  // sign extend
+}
+
+// IEEE 754 half precision of the SEMI type
+inline float zcl_half_to_float(uint16_t half) {
+  uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1F;
+  uint32_t mantissa = half & 0x3FF;
+  uint32_t bits;
+  if (exponent == 0x1F) {
+    bits = sign | 0x7F800000 | mantissa << 13;  // infinity and NaN
+  } else if (exponent != 0) {
+    bits = sign | (exponent + 112) << 23 | mantissa << 13;
+  } else {
+    float value = mantissa / 16777216.0f;  // subnormal, mantissa * 2^-24
+    return sign ? -value : value;
+  }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline uint16_t zcl_float_to_half(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  int32_t exponent = (int32_t) ((bits >> 23) & 0xFF) - 112;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  if (exponent == 0xFF - 112) {
+    return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);  // infinity and NaN
+  }
+  if (exponent >= 0x1F) {
+    return sign | 0x7C00;  // too large
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;  // too small
+    }
+    mantissa |= 0x800000;
+    uint32_t shift = 14 - exponent;
+    return sign | ((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1));
+  }
+  // rounding may carry into the exponent, which is still correct
+  return (sign | exponent << 10 | mantissa >> 13) + ((mantissa >> 12) & 1);
+}
+
+// Writes value in the encoding of a fixed size type, out must hold zcl_fixed_size(type) bytes
+template<class T> void zcl_encode_value(uint8_t type, T value, uint8_t *out) {
+  switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_SEMI: {
+      uint16_t half = zcl_float_to_half((float) value);
+      memcpy(out, &half, sizeof(half));
+      return;
+    }
+    case ESP_ZB_ZCL_ATTR_TYPE_SINGLE: {
+      float single = (float) value;
+      memcpy(out, &single, sizeof(single));
+      return;
+    }
+    case ESP_ZB_ZCL_ATTR_TYPE_DOUBLE: {
+      double dbl = (double) value;
+      memcpy(out, &dbl, sizeof(dbl));
+      return;
+    }
+    default: {
+      uint64_t raw = zcl_is_signed(type) ? (uint64_t) (int64_t) value : (uint64_t) value;
+      uint8_t size = zcl_fixed_size(type);
+      memcpy(out, &raw, size < sizeof(raw) ? size : sizeof(raw));
+      return;
+    }
+  }
+}
+
+// Reads a value of any ZCL type as T. Strings and arrays are returned as std::string, other types not
+// representable in T (e.g. a string read as number) as T{}.
+template<class T> T get_value_by_type(uint8_t attr_type, const void *data) {
+  if constexpr (std::is_same<T, std::string>::value) {
+    ZBBytesView view = zcl_bytes_view(attr_type, data);
+    return view.size > 0 ? std::string((const char *) view.data, view.size) : std::string();
+  } else {
+    const uint8_t *bytes = (const uint8_t *) data;
+    switch (attr_type) {
+      case ESP_ZB_ZCL_ATTR_TYPE_SEMI: {
+        uint16_t half;
+        memcpy(&half, bytes, sizeof(half));
+        return (T) zcl_half_to_float(half);
+      }
+      case ESP_ZB_ZCL_ATTR_TYPE_SINGLE: {
+        float single;
+        memcpy(&single, bytes, sizeof(single));
+        return (T) single;
+      }
+      case ESP_ZB_ZCL_ATTR_TYPE_DOUBLE: {
+        double dbl;
+        memcpy(&dbl, bytes, sizeof(dbl));
+        return (T) dbl;
+      }
+      default:
+        break;
+    }
+    uint8_t size = zcl_fixed_size(attr_type);
+    if (size == 0 || size > 8) {
+      return T{};  // strings, arrays, structures and keys
+    }
+    return zcl_is_signed(attr_type) ? (T) zcl_read_signed(bytes, size) : (T) zcl_read_unsigned(bytes, size);
+  }
+}
+
+// Encodes data with the length prefix of a string or array type, truncated to max_size. With use_max_size the
+// length is max_size and the rest zero filled, the stack takes it as capacity of the attribute.
+uint8_t *get_zcl_bytes(uint8_t type, const void *data, size_t size, uint16_t max_size, bool use_max_size = false);
+
+}  // namespace zigbee
+}  // namespace esphome
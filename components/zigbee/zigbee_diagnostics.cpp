@@ -0,0 +1,111 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+// Read only attributes the coordinator can configure reporting for
+static constexpr uint8_t DIAG_ACCESS = ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING;
+
+static const ZBDiagAttr DIAG_ATTRS[] = {
+    {DIAG_ATTR_NUMBER_OF_RESETS, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_PERSISTENT_MEMORY_WRITES, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_MAC_RX_BCAST, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_MAC_TX_BCAST, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_MAC_RX_UCAST, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_MAC_TX_UCAST, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_MAC_TX_UCAST_RETRY, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_MAC_TX_UCAST_FAIL, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_APS_TX_BCAST, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_APS_TX_UCAST_SUCCESS, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_APS_TX_UCAST_RETRY, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_APS_TX_UCAST_FAIL, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_PACKET_BUFFER_ALLOC_FAILURES, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_AVERAGE_MAC_RETRY_PER_APS, ESP_ZB_ZCL_ATTR_TYPE_U16},
+    {DIAG_ATTR_LAST_MESSAGE_LQI, ESP_ZB_ZCL_ATTR_TYPE_U8},
+    {DIAG_ATTR_LAST_MESSAGE_RSSI, ESP_ZB_ZCL_ATTR_TYPE_S8},
+};
+
+static const ZBDiagAttr DIAG_COMPONENT_ATTRS[] = {
+    {DIAG_ATTR_EVENTS_DROPPED, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_QUEUE_HIGH_WATER, ESP_ZB_ZCL_ATTR_TYPE_U8},
+    {DIAG_ATTR_LOCK_TIMEOUTS, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_REPORTS_RECEIVED, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_REPORTS_SENT, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_TASK_STACK_FREE, ESP_ZB_ZCL_ATTR_TYPE_U32},
+    {DIAG_ATTR_HEAP_MIN_FREE, ESP_ZB_ZCL_ATTR_TYPE_U32},
+};
+
+void ZigBeeComponent::create_diagnostics_server_() {
+  uint8_t endpoint_id = this->diagnostics_endpoint_;
+  if (this->endpoint_list_.find(endpoint_id) == this->endpoint_list_.end()) {
+    ESP_LOGE(TAG, "Could not create diagnostics server, endpoint %u does not exist", endpoint_id);
+    this->diagnostics_endpoint_ = 0;
+    return;
+  }
+  this->add_diagnostics_attrs_(ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, DIAG_ATTRS,
+                               sizeof(DIAG_ATTRS) / sizeof(DIAG_ATTRS[0]));
+  this->add_diagnostics_attrs_(this->diagnostics_cluster_, DIAG_COMPONENT_ATTRS,
+                               sizeof(DIAG_COMPONENT_ATTRS) / sizeof(DIAG_COMPONENT_ATTRS[0]));
+}
+
+void ZigBeeComponent::add_diagnostics_attrs_(uint16_t cluster_id, const ZBDiagAttr *attrs, size_t count) {
+  uint8_t endpoint_id = this->diagnostics_endpoint_;
+  if (this->attribute_list_.find({endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE}) ==
+      this->attribute_list_.end()) {
+    this->add_cluster(endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+  }
+  for (size_t i = 0; i < count; i++) {
+    // all counters start at zero, the value buffer is large enough for every type
+    this->add_attr(endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attrs[i].id, attrs[i].type, DIAG_ACCESS, 0,
+                   (uint32_t) 0);
+  }
+}
+
+template<typename T> static void set_diag_attr(uint8_t endpoint_id, uint16_t cluster_id, uint16_t attr_id, T value) {
+  esp_zb_zcl_set_attribute_val(endpoint_id, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id, &value, false);
+}
+
+// Runs in the Zigbee task, so the attributes are written without taking the lock. Changed values are reported by
+// the stack according to the reporting configured by the coordinator.
+void ZigBeeComponent::update_diagnostics(const zdo_diagnostics_full_stats_t &stats) {
+  uint8_t ep = this->diagnostics_endpoint_;
+  if (ep == 0) {
+    return;
+  }
+  const auto &mac = stats.mac_stats;
+  const auto &zdo = stats.zdo_stats;
+  const uint16_t diag = ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS;
+  const uint16_t own = this->diagnostics_cluster_;
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_NUMBER_OF_RESETS, zdo.number_of_resets);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_PERSISTENT_MEMORY_WRITES, zdo.persistent_memory_writes);
+  set_diag_attr<uint32_t>(ep, diag, DIAG_ATTR_MAC_RX_BCAST, mac.mac_rx_bcast);
+  set_diag_attr<uint32_t>(ep, diag, DIAG_ATTR_MAC_TX_BCAST, mac.mac_tx_bcast);
+  set_diag_attr<uint32_t>(ep, diag, DIAG_ATTR_MAC_RX_UCAST, mac.mac_rx_ucast);
+  set_diag_attr<uint32_t>(ep, diag, DIAG_ATTR_MAC_TX_UCAST, mac.mac_tx_ucast_total);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_MAC_TX_UCAST_RETRY, mac.mac_tx_ucast_retries);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_MAC_TX_UCAST_FAIL, mac.mac_tx_ucast_failures);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_APS_TX_BCAST, zdo.aps_tx_bcast);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_APS_TX_UCAST_SUCCESS, zdo.aps_tx_ucast_success);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_APS_TX_UCAST_RETRY, zdo.aps_tx_ucast_retry);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_APS_TX_UCAST_FAIL, zdo.aps_tx_ucast_fail);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_PACKET_BUFFER_ALLOC_FAILURES, zdo.packet_buffer_allocate_failures);
+  set_diag_attr<uint16_t>(ep, diag, DIAG_ATTR_AVERAGE_MAC_RETRY_PER_APS, zdo.average_mac_retry_per_aps_message_sent);
+  set_diag_attr<uint8_t>(ep, diag, DIAG_ATTR_LAST_MESSAGE_LQI, mac.last_msg_lqi);
+  set_diag_attr<int8_t>(ep, diag, DIAG_ATTR_LAST_MESSAGE_RSSI, mac.last_msg_rssi);
+  // written by the main loop, 32 bit reads do not tear
+  const PipelineStats &pipeline = this->pipeline_stats_;
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_EVENTS_DROPPED, pipeline.events_dropped);
+  set_diag_attr<uint8_t>(ep, own, DIAG_ATTR_QUEUE_HIGH_WATER, pipeline.queue_high_water);
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_LOCK_TIMEOUTS, this->get_lock_timeouts());
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_REPORTS_RECEIVED, pipeline.reports_received);
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_REPORTS_SENT, pipeline.reports_sent);
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_TASK_STACK_FREE, this->get_task_stack_free());
+  set_diag_attr<uint32_t>(ep, own, DIAG_ATTR_HEAP_MIN_FREE, this->get_heap_min_free());
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
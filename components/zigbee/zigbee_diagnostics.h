@@ -0,0 +1,45 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_DIAGNOSTICS
+#include <cstdint>
+
+namespace esphome {
+namespace zigbee {
+
+// Attributes of the Diagnostics cluster (ZCL 3.15) filled from zdo_diagnostics_full_stats_t
+static constexpr uint16_t DIAG_ATTR_NUMBER_OF_RESETS = 0x0000;
+static constexpr uint16_t DIAG_ATTR_PERSISTENT_MEMORY_WRITES = 0x0001;
+static constexpr uint16_t DIAG_ATTR_MAC_RX_BCAST = 0x0100;
+static constexpr uint16_t DIAG_ATTR_MAC_TX_BCAST = 0x0101;
+static constexpr uint16_t DIAG_ATTR_MAC_RX_UCAST = 0x0102;
+static constexpr uint16_t DIAG_ATTR_MAC_TX_UCAST = 0x0103;
+static constexpr uint16_t DIAG_ATTR_MAC_TX_UCAST_RETRY = 0x0104;
+static constexpr uint16_t DIAG_ATTR_MAC_TX_UCAST_FAIL = 0x0105;
+static constexpr uint16_t DIAG_ATTR_APS_TX_BCAST = 0x0107;
+static constexpr uint16_t DIAG_ATTR_APS_TX_UCAST_SUCCESS = 0x0109;
+static constexpr uint16_t DIAG_ATTR_APS_TX_UCAST_RETRY = 0x010A;
+static constexpr uint16_t DIAG_ATTR_APS_TX_UCAST_FAIL = 0x010B;
+static constexpr uint16_t DIAG_ATTR_PACKET_BUFFER_ALLOC_FAILURES = 0x0117;
+static constexpr uint16_t DIAG_ATTR_AVERAGE_MAC_RETRY_PER_APS = 0x011B;
+static constexpr uint16_t DIAG_ATTR_LAST_MESSAGE_LQI = 0x011C;
+static constexpr uint16_t DIAG_ATTR_LAST_MESSAGE_RSSI = 0x011D;
+// Counters of this component, in a custom cluster (0xFC00 by default) on the same endpoint. The 0xF000 - 0xFFFE
+// attributes of the Diagnostics cluster are global attributes of the ZCL, not free for a manufacturer.
+static constexpr uint16_t DIAG_ATTR_EVENTS_DROPPED = 0x0000;
+static constexpr uint16_t DIAG_ATTR_QUEUE_HIGH_WATER = 0x0001;
+static constexpr uint16_t DIAG_ATTR_LOCK_TIMEOUTS = 0x0002;
+static constexpr uint16_t DIAG_ATTR_REPORTS_RECEIVED = 0x0003;
+static constexpr uint16_t DIAG_ATTR_REPORTS_SENT = 0x0004;
+static constexpr uint16_t DIAG_ATTR_TASK_STACK_FREE = 0x0005;
+static constexpr uint16_t DIAG_ATTR_HEAP_MIN_FREE = 0x0006;
+
+struct ZBDiagAttr {
+  uint16_t id;
+  uint8_t type;
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
@@ -9,6 +9,7 @@ from esphome.const import (
     CONF_ID,
     CONF_LAMBDA,
     CONF_MAX_LENGTH,
+    CONF_PLATFORM,
     CONF_TYPE,
     CONF_UNIT_OF_MEASUREMENT,
     CONF_VALUE,
@@ -557,6 +558,9 @@ def create_device_ep(eps, dev, generic=False):
 def get_device_entries(conf: list, component_type):
     devices = []
     for d in conf:
+        if d.get(CONF_PLATFORM) == "zigbee":
+            # diagnostic entities of this component are never exposed as endpoints
+            continue
         if CONF_ID in d and d[CONF_ID].type.inherits_from(component_type):
             devices.append(d)
         else:
@@ -0,0 +1,41 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_FAST_PATH
+
+namespace esphome {
+namespace zigbee {
+
+void ZigBeeComponent::apply_fast_output(uint8_t endpoint, uint16_t cluster, const esp_zb_zcl_attribute_t &attribute,
+                                        uint32_t start) {
+  if (attribute.data.value == nullptr) {
+    return;
+  }
+  // a handful of entries, a linear scan is cheaper than a map lookup
+  for (const ZBFastOutput &fast : this->fast_outputs_) {
+    if (fast.endpoint != endpoint || fast.cluster != cluster || fast.attr_id != attribute.id) {
+      continue;
+    }
+    fast.output->set_state(get_value_by_type<bool>(attribute.data.type, attribute.data.value));
+    uint32_t latency = micros() - start;
+    portENTER_CRITICAL(&this->fast_latency_lock_);
+    this->fast_latency_.add(latency);
+    portEXIT_CRITICAL(&this->fast_latency_lock_);
+  }
+}
+
+ZBLatencyStats ZigBeeComponent::get_fast_path_latency() {
+  portENTER_CRITICAL(&this->fast_latency_lock_);
+  ZBLatencyStats stats = this->fast_latency_;
+  portEXIT_CRITICAL(&this->fast_latency_lock_);
+  return stats;
+}
+
+bool ZigBeeComponent::has_fast_output_(uint8_t endpoint, uint16_t cluster, uint16_t attr_id) const {
+  return std::any_of(this->fast_outputs_.begin(), this->fast_outputs_.end(), [&](const ZBFastOutput &fast) {
+    return fast.endpoint == endpoint && fast.cluster == cluster && fast.attr_id == attr_id;
+  });
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
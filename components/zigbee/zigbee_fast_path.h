@@ -0,0 +1,37 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_FAST_PATH
+#include <algorithm>
+#include <cstdint>
+#include "esphome/components/output/binary_output.h"
+
+namespace esphome {
+namespace zigbee {
+
+// Output switched in the Zigbee task when the attribute is written by the network, before the event reaches the
+// main loop. The output must be safe to call from another task (e.g. a GPIO output without power supply).
+struct ZBFastOutput {
+  uint8_t endpoint;
+  uint16_t cluster;
+  uint16_t attr_id;
+  output::BinaryOutput *output;
+};
+
+// Time from the attribute callback of the stack until the value was applied, in us
+struct ZBLatencyStats {
+  uint32_t count;
+  uint32_t max;
+  float avg;  // moving average over the last ~8 values
+
+  void add(uint32_t latency) {
+    this->count++;
+    this->max = std::max(this->max, latency);
+    this->avg = this->count == 1 ? latency : this->avg + (latency - this->avg) / 8.0f;
+  }
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
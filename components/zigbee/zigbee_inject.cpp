@@ -0,0 +1,127 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_INJECT
+#include <algorithm>
+#include <cstring>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+bool ZBEventInjector::start(Component *parent, const ZBInjectConfig &config) {
+  if (this->running_) {
+    ESP_LOGW(TAG, "Event injection already running");
+    return false;
+  }
+  if (config.size > MAX_INJECT_VALUE) {
+    return false;
+  }
+  this->parent_ = parent;
+  this->config_ = config;
+  this->result_ = {};
+  this->running_ = true;
+  // below the Zigbee task, above the main loop like the Zigbee task
+  if (xTaskCreate(task_, "zb_inject", 3072, this, 5, nullptr) != pdPASS) {
+    this->running_ = false;
+    return false;
+  }
+  return true;
+}
+
+void ZBEventInjector::task_(void *arg) {
+  static_cast<ZBEventInjector *>(arg)->run_();
+  vTaskDelete(nullptr);
+}
+
+void ZBEventInjector::run_() {
+  int64_t start = esp_timer_get_time();
+  for (uint32_t i = 0; i < this->config_.count; i++) {
+    if (this->config_.rate > 0) {
+      // rates above the tick rate are injected in bursts
+      int64_t wait = start + (int64_t) i * 1000000 / this->config_.rate - esp_timer_get_time();
+      if (wait >= portTICK_PERIOD_MS * 1000) {
+        vTaskDelay(wait / 1000 / portTICK_PERIOD_MS);
+      }
+    } else if (i % MAX_ZB_QUEUE_SIZE == 0) {
+      vTaskDelay(1);  // lets the main loop run
+    }
+    esp_zb_lock_acquire(portMAX_DELAY);
+    esp_err_t err = this->inject_(i);
+    esp_zb_lock_release();
+    if (err == ESP_OK) {
+      this->result_.injected++;
+    } else {
+      this->result_.rejected++;
+    }
+  }
+  this->result_.duration = (esp_timer_get_time() - start) / 1000;
+  this->running_ = false;
+  this->finished_ = true;
+  this->parent_->enable_loop_soon_any_context();
+}
+
+esp_err_t ZBEventInjector::inject_(uint32_t seq) {
+  const ZBInjectConfig &config = this->config_;
+  // the value changes with every event
+  uint8_t prefix = zcl_length_prefix(config.attr_type);
+  if (prefix != 0) {
+    uint16_t length = config.size > prefix ? config.size - prefix : 0;
+    memcpy(this->value_, &length, prefix);  // little endian
+    memset(this->value_ + prefix, 'a' + seq % 26, length);
+  } else {
+    memset(this->value_, 0, config.size);
+    memcpy(this->value_, &seq, std::min<size_t>(config.size, sizeof(seq)));
+  }
+  esp_zb_zcl_attribute_t attribute = {};
+  attribute.id = config.attr_id;
+  attribute.data.type = (esp_zb_zcl_attr_type_t) config.attr_type;
+  attribute.data.size = config.size;
+  attribute.data.value = this->value_;
+  return inject_zb_event(config.event, config.endpoint, config.cluster, attribute);
+}
+
+esp_err_t inject_zb_event(ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, esp_zb_zcl_attribute_t attribute) {
+  switch (event) {
+    case INJECT_SET_ATTR: {
+      esp_zb_zcl_set_attr_value_message_t message = {};
+      message.info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+      message.info.dst_endpoint = endpoint;
+      message.info.cluster = cluster;
+      message.attribute = attribute;
+      return zb_action_handler(ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, &message);
+    }
+    case INJECT_REPORT_ATTR: {
+      esp_zb_zcl_report_attr_message_t message = {};
+      message.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+      message.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+      message.src_address.u.short_addr = INJECT_SRC_ADDRESS;
+      message.src_endpoint = 1;
+      message.dst_endpoint = endpoint;
+      message.cluster = cluster;
+      message.attribute = attribute;
+      return zb_action_handler(ESP_ZB_CORE_REPORT_ATTR_CB_ID, &message);
+    }
+    case INJECT_READ_RESP: {
+      esp_zb_zcl_read_attr_resp_variable_t variable = {};
+      variable.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+      variable.attribute = attribute;
+      esp_zb_zcl_cmd_read_attr_resp_message_t message = {};
+      message.info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+      message.info.src_address.addr_type = ESP_ZB_ZCL_ADDR_TYPE_SHORT;
+      message.info.src_address.u.short_addr = INJECT_SRC_ADDRESS;
+      message.info.src_endpoint = 1;
+      message.info.dst_endpoint = endpoint;
+      message.info.cluster = cluster;
+      message.variables = &variable;
+      return zb_action_handler(ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID, &message);
+    }
+  }
+  return ESP_ERR_INVALID_ARG;
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
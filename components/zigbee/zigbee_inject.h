@@ -0,0 +1,67 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_INJECT
+#include <atomic>
+#include "esphome/core/component.h"
+#include "esp_zigbee_core.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr uint16_t MAX_INJECT_VALUE = 256;  // length (2 bytes for long strings) and 254 characters
+static constexpr uint16_t INJECT_SRC_ADDRESS = 0x0000;
+
+enum ZBInjectEvent : uint8_t {
+  INJECT_SET_ATTR = 0,
+  INJECT_REPORT_ATTR,
+  INJECT_READ_RESP,
+};
+
+struct ZBInjectConfig {
+  ZBInjectEvent event;
+  uint32_t count;
+  uint32_t rate;  // events per second, 0: one queue full per tick
+  uint8_t endpoint;
+  uint16_t cluster;
+  uint16_t attr_id;
+  uint8_t attr_type;
+  uint16_t size;  // size of the value, including the length byte of strings
+};
+
+struct ZBInjectResult {
+  uint32_t injected;
+  uint32_t rejected;  // the handler returned an error
+  uint32_t duration;  // ms
+};
+
+// Passes one synthetic stack callback to zb_action_handler, the Zigbee lock must be held
+esp_err_t inject_zb_event(ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, esp_zb_zcl_attribute_t attribute);
+
+// Calls zb_action_handler with synthetic stack callbacks from a separate task while holding the Zigbee lock, like the
+// Zigbee task does. Exercises the event pipeline and the handlers in the main loop without radio traffic.
+class ZBEventInjector {
+ public:
+  bool start(Component *parent, const ZBInjectConfig &config);
+  bool is_running() const { return this->running_; }
+  // true once after each run, the result stays valid until the next start
+  bool take_finished() { return this->finished_.exchange(false); }
+  const ZBInjectResult &get_result() const { return this->result_; }
+
+ protected:
+  static void task_(void *arg);
+  void run_();
+  esp_err_t inject_(uint32_t seq);
+
+  Component *parent_{nullptr};
+  ZBInjectConfig config_{};
+  ZBInjectResult result_{};
+  uint8_t value_[MAX_INJECT_VALUE];
+  std::atomic<bool> running_{false};
+  std::atomic<bool> finished_{false};
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
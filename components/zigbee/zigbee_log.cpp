@@ -0,0 +1,57 @@
+#include "zigbee.h"
+#include <cinttypes>
+
+namespace esphome {
+namespace zigbee {
+
+struct ZBLogFormat {
+  uint8_t level;
+  const char *tag;
+  const char *format;
+};
+
+// indexed by ZBLogId
+static const ZBLogFormat ZB_LOG_FORMATS[] = {
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "turned off"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "got level"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Receive Zigbee default response callback"},
+    {ESPHOME_LOG_LEVEL_WARN, TAG, "Receive Zigbee action(0x%x) callback"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "No handler for command 0x%02x (endpoint %u; cluster 0x%04x)"},
+    {ESPHOME_LOG_LEVEL_WARN, TAG, "Command 0x%02x payload too large (%u bytes)"},
+    {ESPHOME_LOG_LEVEL_WARN, TAG, "Group 0x%04x on endpoint %u: status %d"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Binding table callback for address 0x%04x with status %d"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Binding table info: total %d, index %d, count %d"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "No binding table entries found"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG,
+     "Binding table record: src_endp %d, dst_endp %d, cluster_id 0x%04x, dst_addr_mode %d"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG,
+     "Device bound to EP %d -> device endpoint: %d, short addr: 0x%04x, ieee addr: %08" PRIX32 "%08" PRIX32},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Filling bounded devices finished"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "OTA progress: %" PRIu32 "/%" PRIu32 " bytes"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "OTA upgrade status: %d"},
+    {ESPHOME_LOG_LEVEL_WARN, TAG, "Scene %u full, attribute 0x%04x of cluster 0x%04x not stored"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Store scene %u of group 0x%04x on endpoint %u (%u bytes)"},
+    {ESPHOME_LOG_LEVEL_DEBUG, TAG, "Recall scene %u of group 0x%04x on endpoint %u (%u bytes)"},
+};
+static_assert(sizeof(ZB_LOG_FORMATS) / sizeof(ZB_LOG_FORMATS[0]) == ZB_LOG_COUNT, "Missing deferred log format");
+
+void ZBDeferredLog::process() {
+  uint8_t tail = this->tail_.load(std::memory_order_relaxed);
+  while (tail != this->head_.load(std::memory_order_acquire)) {
+    const ZBLogRecord &record = this->records_[tail];
+    const ZBLogFormat &format = ZB_LOG_FORMATS[record.id];
+    // unused arguments are ignored by the format
+    esp_log_printf_(format.level, format.tag, record.line, format.format, record.args[0], record.args[1],
+                    record.args[2], record.args[3], record.args[4], record.args[5]);
+    tail = (tail + 1) % ZB_LOG_QUEUE_SIZE;
+    this->tail_.store(tail, std::memory_order_release);
+  }
+  uint16_t dropped = this->dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped > 0) {
+    ESP_LOGW(TAG, "Dropped %u log messages of the Zigbee task", dropped);
+  }
+}
+
+}  // namespace zigbee
+}  // namespace esphome
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr uint8_t ZB_LOG_QUEUE_SIZE = 32;
+static constexpr uint8_t ZB_LOG_MAX_ARGS = 6;
+
+// Messages of the Zigbee task, the formats are in ZB_LOG_FORMATS
+enum ZBLogId : uint8_t {
+  ZB_LOG_SET_ATTR = 0,
+  ZB_LOG_TURNED_OFF,
+  ZB_LOG_GOT_LEVEL,
+  ZB_LOG_DEFAULT_RESP,
+  ZB_LOG_UNHANDLED_ACTION,
+  ZB_LOG_NO_CMD_HANDLER,
+  ZB_LOG_CMD_TOO_LARGE,
+  ZB_LOG_GROUP_STATUS,
+  ZB_LOG_BINDING_STATUS,
+  ZB_LOG_BINDING_INFO,
+  ZB_LOG_BINDING_EMPTY,
+  ZB_LOG_BINDING_RECORD,
+  ZB_LOG_BINDING_DEVICE,
+  ZB_LOG_BINDING_DONE,
+  ZB_LOG_OTA_PROGRESS,
+  ZB_LOG_OTA_STATUS,
+  ZB_LOG_SCENE_FULL,
+  ZB_LOG_SCENE_STORE,
+  ZB_LOG_SCENE_RECALL,
+  ZB_LOG_COUNT,
+};
+
+struct ZBLogRecord {
+  ZBLogId id;
+  uint16_t line;
+  uint32_t args[ZB_LOG_MAX_ARGS];
+};
+
+// Fixed size records written by the Zigbee task (or a task holding the Zigbee lock) and formatted in the main loop,
+// keeps printf formatting off the radio path. Only integer arguments, messages are dropped if the ring is full.
+class ZBDeferredLog {
+ public:
+  template<typename... Args> void log(ZBLogId id, int line, Args... args) {
+    static_assert(sizeof...(Args) <= ZB_LOG_MAX_ARGS, "Too many arguments for a deferred log message");
+    uint8_t head = this->head_.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) % ZB_LOG_QUEUE_SIZE;
+    if (next == this->tail_.load(std::memory_order_acquire)) {
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ZBLogRecord &record = this->records_[head];
+    record.id = id;
+    record.line = line;
+    [[maybe_unused]] uint8_t i = 0;
+    ((record.args[i++] = (uint32_t) args), ...);
+    this->head_.store(next, std::memory_order_release);
+  }
+  // Formats the pending records in the main loop
+  void process();
+
+ protected:
+  ZBLogRecord records_[ZB_LOG_QUEUE_SIZE];
+  std::atomic<uint8_t> head_{0};
+  std::atomic<uint8_t> tail_{0};
+  std::atomic<uint16_t> dropped_{0};
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+
+// Deferred counterparts of ESP_LOGx for the Zigbee task, compiled out below the configured log level
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+#define ZB_DEFER_LOGD(id, ...) esphome::zigbee::global_zigbee->defer_log(id, __LINE__, ##__VA_ARGS__)
+#else
+#define ZB_DEFER_LOGD(id, ...) \
+  do { \
+  } while (0)
+#endif
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_WARN
+#define ZB_DEFER_LOGW(id, ...) esphome::zigbee::global_zigbee->defer_log(id, __LINE__, ##__VA_ARGS__)
+#else
+#define ZB_DEFER_LOGW(id, ...) \
+  do { \
+  } while (0)
+#endif
@@ -0,0 +1,392 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_OTA
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <new>
+#include "esp_app_format.h"
+#include "esp_ota_ops.h"
+#include "nvs_flash.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr uint32_t OTA_WRITE_TIMEOUT = 10000;       // ms, a sector erase takes well below a second
+static constexpr uint32_t OTA_FAST_POLL_TIMEOUT = 300000;  // ms, renewed while blocks arrive
+
+struct OtaProgress {
+  OtaImage image;
+  uint32_t committed;
+};
+
+esp_err_t ZigBeeOtaWriter::begin(const OtaImage &image) {
+  if (this->is_active()) {
+    this->abort();
+  }
+  this->partition_ = esp_ota_get_next_update_partition(nullptr);
+  if (this->partition_ == nullptr) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  this->image_ = image;
+  this->resume_ = 0;
+  OtaProgress progress{};
+  size_t size = sizeof(progress);
+  nvs_handle_t handle;
+  if (nvs_open(OTA_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+    if (nvs_get_blob(handle, "progress", &progress, &size) == ESP_OK && size == sizeof(progress) &&
+        memcmp(&progress.image, &image, sizeof(image)) == 0) {
+      this->resume_ = progress.committed;
+    }
+    nvs_close(handle);
+  }
+
+  this->buffers_[0] = new (std::nothrow) uint8_t[OTA_BUFFER_SIZE];
+  this->buffers_[1] = new (std::nothrow) uint8_t[OTA_BUFFER_SIZE];
+  this->chunks_ = xQueueCreate(2, sizeof(Chunk));
+  this->free_ = xSemaphoreCreateCounting(2, 2);
+  if (this->buffers_[0] == nullptr || this->buffers_[1] == nullptr || this->chunks_ == nullptr ||
+      this->free_ == nullptr || xTaskCreate(writer_task_, "zb_ota", 3072, this, 5, &this->task_) != pdPASS) {
+    this->task_ = nullptr;
+    this->cleanup_();
+    return ESP_ERR_NO_MEM;
+  }
+  xSemaphoreTake(this->free_, 0);
+  this->holding_ = true;
+  this->active_ = 0;
+  this->fill_ = 0;
+  this->buffer_offset_ = 0;
+  this->element_header_fill_ = 0;
+  this->element_size_ = 0;
+  this->received_ = 0;
+  this->committed_ = 0;
+  this->error_ = ESP_OK;
+  if (this->resume_ > 0) {
+    ESP_LOGI(TAG, "Resuming OTA image, %" PRIu32 " bytes are already in flash", this->resume_);
+  }
+  return ESP_OK;
+}
+
+esp_err_t ZigBeeOtaWriter::write(const uint8_t *data, size_t size) {
+  if (!this->is_active()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (this->error_ != ESP_OK) {
+    return this->error_;
+  }
+  while (this->element_header_fill_ < OTA_ELEMENT_HEADER_SIZE && size > 0) {
+    this->element_header_[this->element_header_fill_++] = *data++;
+    size--;
+    if (this->element_header_fill_ == OTA_ELEMENT_HEADER_SIZE) {
+      uint16_t tag = this->element_header_[0] | (this->element_header_[1] << 8);
+      memcpy(&this->element_size_, this->element_header_ + 2, sizeof(this->element_size_));
+      if (tag != OTA_UPGRADE_IMAGE_TAG || this->element_size_ > this->partition_->size) {
+        ESP_LOGE(TAG, "Unsupported OTA element 0x%04x with %" PRIu32 " bytes", tag, this->element_size_);
+        return ESP_ERR_NOT_SUPPORTED;
+      }
+    }
+  }
+  if (this->received_ == 0 && size > 0 && data[0] != ESP_IMAGE_HEADER_MAGIC) {
+    ESP_LOGE(TAG, "OTA image is no ESP app image");
+    return ESP_ERR_INVALID_ARG;
+  }
+  // elements following the upgrade image are ignored
+  size = std::min<size_t>(size, this->element_size_ - this->received_);
+  while (size > 0) {
+    size_t len = std::min<size_t>(size, OTA_BUFFER_SIZE - this->fill_);
+    memcpy(this->buffers_[this->active_] + this->fill_, data, len);
+    this->fill_ += len;
+    this->received_ += len;
+    data += len;
+    size -= len;
+    if (this->fill_ == OTA_BUFFER_SIZE) {
+      esp_err_t err = this->submit_(false);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t ZigBeeOtaWriter::submit_(bool last) {
+  Chunk chunk = {this->active_, this->buffer_offset_, this->fill_};
+  this->holding_ = false;
+  xQueueSend(this->chunks_, &chunk, portMAX_DELAY);  // never blocks, there are only two buffers
+  this->active_ ^= 1;
+  this->fill_ = 0;
+  this->buffer_offset_ += OTA_BUFFER_SIZE;
+  if (last) {
+    return ESP_OK;
+  }
+  // Only waits if the flash is slower than the radio
+  if (xSemaphoreTake(this->free_, pdMS_TO_TICKS(OTA_WRITE_TIMEOUT)) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
+  this->holding_ = true;
+  return this->error_;
+}
+
+void ZigBeeOtaWriter::writer_task_(void *arg) {
+  auto *writer = static_cast<ZigBeeOtaWriter *>(arg);
+  Chunk chunk;
+  while (true) {
+    if (xQueueReceive(writer->chunks_, &chunk, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    if (writer->error_ == ESP_OK) {
+      writer->error_ = writer->write_chunk_(chunk);
+    }
+    xSemaphoreGive(writer->free_);
+  }
+}
+
+esp_err_t ZigBeeOtaWriter::write_chunk_(const Chunk &chunk) {
+  const uint8_t *data = this->buffers_[chunk.index];
+  if (chunk.offset + chunk.size <= this->resume_) {
+    uint8_t flash[256];
+    bool same = true;
+    for (uint32_t pos = 0; same && pos < chunk.size; pos += sizeof(flash)) {
+      size_t len = std::min<size_t>(sizeof(flash), chunk.size - pos);
+      same = esp_partition_read(this->partition_, chunk.offset + pos, flash, len) == ESP_OK &&
+             memcmp(flash, data + pos, len) == 0;
+    }
+    if (same) {
+      this->committed_ = chunk.offset + chunk.size;
+      return ESP_OK;
+    }
+    this->resume_ = chunk.offset;  // the flash differs from here on
+  }
+  esp_err_t err = esp_partition_erase_range(this->partition_, chunk.offset, OTA_BUFFER_SIZE);
+  if (err == ESP_OK) {
+    err = esp_partition_write(this->partition_, chunk.offset, data, chunk.size);
+  }
+  if (err != ESP_OK) {
+    return err;
+  }
+  this->committed_ = chunk.offset + chunk.size;
+  if (this->committed_ % OTA_RESUME_INTERVAL == 0) {
+    this->save_progress_();
+  }
+  return ESP_OK;
+}
+
+bool ZigBeeOtaWriter::drain_() {
+  if (this->holding_) {
+    xSemaphoreGive(this->free_);
+    this->holding_ = false;
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    if (xSemaphoreTake(this->free_, pdMS_TO_TICKS(OTA_WRITE_TIMEOUT)) != pdTRUE) {
+      ESP_LOGE(TAG, "OTA flash writer does not respond");
+      return false;  // keep the task and buffers, the writer still uses them
+    }
+  }
+  return true;
+}
+
+esp_err_t ZigBeeOtaWriter::finish() {
+  if (!this->is_active()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (this->error_ == ESP_OK && this->fill_ > 0) {
+    this->submit_(true);
+  }
+  if (!this->drain_()) {
+    return ESP_ERR_TIMEOUT;
+  }
+  esp_err_t err = this->error_;
+  if (err == ESP_OK && (this->element_size_ == 0 || this->received_ != this->element_size_)) {
+    err = ESP_ERR_INVALID_SIZE;
+  }
+  if (err == ESP_OK) {
+    err = esp_ota_set_boot_partition(this->partition_);  // verifies the image
+  }
+  if (this->element_size_ > 0 && this->committed_ == this->element_size_) {
+    this->clear_progress_();
+  } else {
+    this->save_progress_();
+  }
+  this->cleanup_();
+  return err;
+}
+
+void ZigBeeOtaWriter::abort() {
+  if (!this->is_active() || !this->drain_()) {
+    return;
+  }
+  this->save_progress_();
+  this->cleanup_();
+}
+
+void ZigBeeOtaWriter::cleanup_() {
+  if (this->task_ != nullptr) {
+    vTaskDelete(this->task_);  // blocked on the empty queue
+    this->task_ = nullptr;
+  }
+  if (this->chunks_ != nullptr) {
+    vQueueDelete(this->chunks_);
+    this->chunks_ = nullptr;
+  }
+  if (this->free_ != nullptr) {
+    vSemaphoreDelete(this->free_);
+    this->free_ = nullptr;
+  }
+  for (auto &buffer : this->buffers_) {
+    delete[] buffer;
+    buffer = nullptr;
+  }
+}
+
+void ZigBeeOtaWriter::save_progress_() {
+  OtaProgress progress = {this->image_, std::max(this->committed_, this->resume_)};
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(handle, "progress", &progress, sizeof(progress));
+    if (err == ESP_OK) {
+      err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Could not store OTA progress: %s", esp_err_to_name(err));
+  }
+}
+
+void ZigBeeOtaWriter::clear_progress_() {
+  nvs_handle_t handle;
+  if (nvs_open(OTA_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+    nvs_erase_key(handle, "progress");
+    nvs_commit(handle);
+    nvs_close(handle);
+  }
+}
+
+// Sleepy end devices poll their parent continuously while blocks are transferred
+static void set_ota_fast_poll(bool enable) {
+#ifdef ZB_ED_ROLE
+  if (enable) {
+    zb_zdo_pim_start_turbo_poll_continuous(OTA_FAST_POLL_TIMEOUT);
+  } else {
+    zb_zdo_pim_turbo_poll_continuous_leave(0);
+  }
+#endif
+}
+
+void ZigBeeComponent::create_ota_client_() {
+  uint8_t endpoint_id = this->ota_endpoint_;
+  if (this->endpoint_list_.find(endpoint_id) == this->endpoint_list_.end()) {
+    ESP_LOGE(TAG, "Could not create OTA client, endpoint %u does not exist", endpoint_id);
+    return;
+  }
+  esp_zb_ota_cluster_cfg_t ota_cfg = {
+      .ota_upgrade_file_version = this->ota_file_version_,
+      .ota_upgrade_manufacturer = this->ota_manufacturer_,
+      .ota_upgrade_image_type = this->ota_image_type_,
+  };
+  ota_cfg.ota_upgrade_downloaded_file_ver = 0xFFFFFFFF;  // no image downloaded
+  esp_zb_attribute_list_t *attr_list = esp_zb_ota_cluster_create(&ota_cfg);
+  esp_zb_zcl_ota_upgrade_client_variable_t client_cfg = {
+      .timer_query = this->ota_query_interval_,
+      .hw_version = this->basic_cluster_data_.hw_version,
+      .max_data_size = this->ota_block_size_,
+  };
+  uint16_t server_addr = 0xFFFF;  // discovered by the stack
+  uint8_t server_endpoint = 0xFF;
+  esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &client_cfg);
+  esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr);
+  esp_zb_ota_cluster_add_attr(attr_list, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_endpoint);
+  this->attribute_list_[{endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE}] = attr_list;
+}
+
+// Runs in the Zigbee task, the stack downloads the image if ESP_OK is returned
+esp_err_t ZigBeeComponent::on_ota_query_response(const esp_zb_zcl_ota_upgrade_query_image_resp_message_t *message) {
+  if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+    ESP_LOGD(TAG, "No OTA image available");
+    return ESP_OK;
+  }
+  ESP_LOGI(TAG, "OTA image 0x%08" PRIx32 " (%" PRIu32 " bytes) offered by 0x%04x", message->file_version,
+           message->image_size, message->server_addr.u.short_addr);
+  if (message->file_version <= this->ota_file_version_) {
+    ESP_LOGW(TAG, "Rejecting OTA image, running file version is 0x%08" PRIx32, this->ota_file_version_);
+    return ESP_FAIL;
+  }
+  const esp_partition_t *partition = esp_ota_get_next_update_partition(nullptr);
+  if (partition == nullptr || message->image_size > partition->size + OTA_BUFFER_SIZE) {
+    ESP_LOGW(TAG, "Rejecting OTA image, it does not fit into the OTA partition");
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+void ZigBeeComponent::stop_ota_() {
+  this->ota_writer_.abort();
+  set_ota_fast_poll(false);
+}
+
+// Runs in the Zigbee task, blocks are written by the OTA writer task
+esp_err_t ZigBeeComponent::on_ota_upgrade(const esp_zb_zcl_ota_upgrade_value_message_t *message) {
+  if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+    ESP_LOGW(TAG, "OTA upgrade failed with status 0x%02x", message->info.status);
+    this->stop_ota_();
+    return ESP_FAIL;
+  }
+  esp_err_t err = ESP_OK;
+  switch (message->upgrade_status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START: {
+      OtaImage image = {message->ota_header.manufacturer_code, message->ota_header.image_type,
+                        message->ota_header.file_version, message->ota_header.image_size};
+      ESP_LOGI(TAG, "OTA upgrade to file version 0x%08" PRIx32 " started", image.file_version);
+      err = this->ota_writer_.begin(image);
+      set_ota_fast_poll(true);
+      break;
+    }
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE: {
+      if (message->payload_size == 0 || message->payload == nullptr) {
+        break;
+      }
+      uint32_t before = this->ota_writer_.received();
+      err = this->ota_writer_.write((const uint8_t *) message->payload, message->payload_size);
+      if (before / OTA_RESUME_INTERVAL != this->ota_writer_.received() / OTA_RESUME_INTERVAL) {
+        ZB_DEFER_LOGD(ZB_LOG_OTA_PROGRESS, this->ota_writer_.received(), this->ota_writer_.element_size());
+        set_ota_fast_poll(true);
+      }
+      break;
+    }
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+      ESP_LOGI(TAG, "OTA image received");
+      break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+      if (this->ota_writer_.element_size() == 0 || this->ota_writer_.received() != this->ota_writer_.element_size()) {
+        err = ESP_ERR_INVALID_SIZE;
+      }
+      break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+      set_ota_fast_poll(false);
+      err = this->ota_writer_.finish();
+      if (err == ESP_OK) {
+        this->ota_reboot_ = true;
+        this->enable_loop_soon_any_context();
+      }
+      break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR:
+      ESP_LOGW(TAG, "OTA upgrade aborted after %" PRIu32 " bytes", this->ota_writer_.received());
+      this->stop_ota_();
+      break;
+    default:
+      ZB_DEFER_LOGD(ZB_LOG_OTA_STATUS, message->upgrade_status);
+      break;
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "OTA upgrade failed: %s", esp_err_to_name(err));
+    this->stop_ota_();
+  }
+  return err;
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_OTA
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr size_t OTA_BUFFER_SIZE = 4096;                      // one flash sector
+static constexpr uint32_t OTA_RESUME_INTERVAL = 16 * OTA_BUFFER_SIZE;  // progress saved every 64 KB
+static constexpr uint16_t OTA_UPGRADE_IMAGE_TAG = 0x0000;
+static constexpr uint8_t OTA_ELEMENT_HEADER_SIZE = 6;  // tag id and length
+static const char *const OTA_NVS_NAMESPACE = "zb_ota";
+
+struct OtaImage {
+  uint16_t manufacturer;
+  uint16_t image_type;
+  uint32_t file_version;
+  uint32_t image_size;
+};
+
+// Streams the upgrade image element of an OTA file into the inactive app partition. The Zigbee task fills one
+// sector buffer while a writer task erases and programs the other one. Sectors of an interrupted download of the
+// same image are compared with the flash and only written if they differ.
+class ZigBeeOtaWriter {
+ public:
+  esp_err_t begin(const OtaImage &image);
+  // Image data following the OTA file header, called in the Zigbee task
+  esp_err_t write(const uint8_t *data, size_t size);
+  // Waits for the pending sectors and selects the new partition for the next boot
+  esp_err_t finish();
+  // Keeps the progress for a later download of the same image
+  void abort();
+  bool is_active() const { return this->task_ != nullptr; }
+  uint32_t received() const { return this->received_; }
+  uint32_t element_size() const { return this->element_size_; }
+
+ protected:
+  struct Chunk {
+    uint8_t index;
+    uint32_t offset;
+    uint16_t size;
+  };
+  static void writer_task_(void *arg);
+  esp_err_t write_chunk_(const Chunk &chunk);
+  esp_err_t submit_(bool last);
+  bool drain_();
+  void cleanup_();
+  void save_progress_();
+  void clear_progress_();
+
+  const esp_partition_t *partition_{nullptr};
+  OtaImage image_{};
+  uint8_t *buffers_[2]{nullptr, nullptr};
+  uint8_t active_{0};
+  bool holding_{false};  // the Zigbee task owns buffers_[active_]
+  uint16_t fill_{0};
+  uint32_t buffer_offset_{0};
+  uint8_t element_header_[OTA_ELEMENT_HEADER_SIZE];
+  uint8_t element_header_fill_{0};
+  uint32_t element_size_{0};
+  uint32_t received_{0};
+  uint32_t committed_{0};  // written or verified by the writer task
+  uint32_t resume_{0};     // bytes of the partition known from an interrupted download
+  volatile esp_err_t error_{ESP_OK};
+  TaskHandle_t task_{nullptr};
+  QueueHandle_t chunks_{nullptr};
+  SemaphoreHandle_t free_{nullptr};
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
@@ -0,0 +1,331 @@
+#include "zigbee.h"
+
+#ifdef USE_ZIGBEE_TRACE
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace zigbee {
+
+static constexpr uint32_t TRACE_HASH_INIT = 2166136261UL;  // FNV-1a
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+uint32_t trace_hash(uint32_t hash, ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                    uint8_t attr_type, const uint8_t *value, size_t size) {
+  const uint8_t key[] = {event,
+                         endpoint,
+                         (uint8_t) cluster,
+                         (uint8_t) (cluster >> 8),
+                         (uint8_t) attr_id,
+                         (uint8_t) (attr_id >> 8),
+                         attr_type,
+                         (uint8_t) size,
+                         (uint8_t) (size >> 8)};
+  hash = fnv1a(hash, key, sizeof(key));
+  return value != nullptr ? fnv1a(hash, value, size) : hash;
+}
+
+// the size of the value as copied into the event queue
+static uint16_t trace_value_size(const esp_zb_zcl_attribute_t &attribute) {
+  if (attribute.data.value == nullptr) {
+    return 0;
+  }
+  return std::min<size_t>(ZBEvent::get_value_size(attribute.data), UINT16_MAX);
+}
+
+bool read_trace_record(const uint8_t *trace, size_t size, size_t &offset, ZBTraceRecord &record) {
+  if (offset + TRACE_HEADER_SIZE > size) {
+    return false;
+  }
+  const uint8_t *header = trace + offset;
+  uint16_t value_size = encode_uint16(header[12], header[11]);
+  if (header[4] > INJECT_READ_RESP || offset + TRACE_HEADER_SIZE + value_size > size) {
+    return false;
+  }
+  record.time = encode_uint32(header[3], header[2], header[1], header[0]);
+  record.event = (ZBInjectEvent) header[4];
+  record.endpoint = header[5];
+  record.cluster = encode_uint16(header[7], header[6]);
+  record.attr_id = encode_uint16(header[9], header[8]);
+  record.attr_type = header[10];
+  record.size = value_size;
+  record.value = header + TRACE_HEADER_SIZE;
+  offset += TRACE_HEADER_SIZE + record.size;
+  return true;
+}
+
+bool ZBTraceRecorder::init(size_t size) {
+  this->ring_ = (uint8_t *) malloc(size);
+  if (this->ring_ == nullptr) {
+    ESP_LOGE(TAG, "Could not allocate %zu bytes for the event trace", size);
+    return false;
+  }
+  this->size_ = size;
+  return true;
+}
+
+void ZBTraceRecorder::record(ZBInjectEvent event, uint8_t endpoint, uint16_t cluster,
+                             const esp_zb_zcl_attribute_t &attribute) {
+  if (this->ring_ == nullptr || this->paused_) {
+    return;
+  }
+  uint16_t size = trace_value_size(attribute);
+  size_t total = TRACE_HEADER_SIZE + size;
+  if (total > this->size_) {
+    return;
+  }
+  // overwrite the oldest records
+  while (this->size_ - this->used_ < total) {
+    size_t oldest = TRACE_HEADER_SIZE + encode_uint16(this->ring_[(this->head_ + TRACE_HEADER_SIZE - 1) % this->size_],
+                                                      this->ring_[(this->head_ + TRACE_HEADER_SIZE - 2) % this->size_]);
+    this->head_ = (this->head_ + oldest) % this->size_;
+    this->used_ -= oldest;
+    this->records_--;
+    this->overwritten_++;
+  }
+  uint32_t time = (uint32_t) esp_timer_get_time();
+  const uint8_t header[TRACE_HEADER_SIZE] = {(uint8_t) time,
+                                             (uint8_t) (time >> 8),
+                                             (uint8_t) (time >> 16),
+                                             (uint8_t) (time >> 24),
+                                             event,
+                                             endpoint,
+                                             (uint8_t) cluster,
+                                             (uint8_t) (cluster >> 8),
+                                             (uint8_t) attribute.id,
+                                             (uint8_t) (attribute.id >> 8),
+                                             attribute.data.type,
+                                             (uint8_t) size,
+                                             (uint8_t) (size >> 8)};
+  this->put_(header, sizeof(header));
+  this->put_((const uint8_t *) attribute.data.value, size);
+  this->records_++;
+}
+
+void ZBTraceRecorder::put_(const uint8_t *data, size_t size) {
+  size_t tail = (this->head_ + this->used_) % this->size_;
+  size_t first = std::min(size, this->size_ - tail);
+  memcpy(this->ring_ + tail, data, first);
+  memcpy(this->ring_, data + first, size - first);
+  this->used_ += size;
+}
+
+std::vector<uint8_t> ZBTraceRecorder::snapshot() const {
+  std::vector<uint8_t> trace(this->used_);
+  size_t first = std::min(this->used_, this->size_ - this->head_);
+  memcpy(trace.data(), this->ring_ + this->head_, first);
+  memcpy(trace.data() + first, this->ring_, this->used_ - first);
+  return trace;
+}
+
+void ZBTraceRecorder::clear() {
+  this->head_ = 0;
+  this->used_ = 0;
+  this->records_ = 0;
+  this->overwritten_ = 0;
+}
+
+bool ZBTraceReplayer::start(Component *parent, ZBTraceRecorder *recorder, std::vector<uint8_t> trace, float speed) {
+  if (this->running_) {
+    ESP_LOGW(TAG, "Trace replay already running");
+    return false;
+  }
+  if (trace.empty()) {
+    ESP_LOGW(TAG, "Trace is empty");
+    return false;
+  }
+  this->parent_ = parent;
+  this->recorder_ = recorder;
+  this->trace_ = std::move(trace);
+  this->speed_ = speed;
+  this->result_ = {};
+  this->dispatched_ = 0;
+  this->dropped_ = 0;
+  this->hash_ = TRACE_HASH_INIT;
+  this->latencies_.clear();
+  this->latencies_.reserve(std::min<size_t>(this->trace_.size() / TRACE_HEADER_SIZE, MAX_TRACE_LATENCIES));
+  this->replayed_ = false;
+  this->running_ = true;
+  // same priority as the event injector
+  if (xTaskCreate(task_, "zb_replay", 3072, this, 5, nullptr) != pdPASS) {
+    this->running_ = false;
+    return false;
+  }
+  return true;
+}
+
+void ZBTraceReplayer::task_(void *arg) {
+  static_cast<ZBTraceReplayer *>(arg)->run_();
+  vTaskDelete(nullptr);
+}
+
+void ZBTraceReplayer::run_() {
+  // replayed events are not recorded again
+  this->recorder_->set_paused(true);
+  uint32_t hash = TRACE_HASH_INIT;
+  int64_t start = esp_timer_get_time();
+  uint32_t first = 0;
+  size_t offset = 0;
+  ZBTraceRecord record;
+  while (read_trace_record(this->trace_.data(), this->trace_.size(), offset, record)) {
+    if (this->result_.records == 0) {
+      first = record.time;
+    }
+    if (this->speed_ > 0) {
+      int64_t wait = start + (int64_t) ((record.time - first) / this->speed_) - esp_timer_get_time();
+      if (wait >= portTICK_PERIOD_MS * 1000) {
+        vTaskDelay(wait / 1000 / portTICK_PERIOD_MS);
+      }
+    } else if (this->result_.records % MAX_ZB_QUEUE_SIZE == 0) {
+      vTaskDelay(1);  // lets the main loop run
+    }
+    esp_zb_zcl_attribute_t attribute = {};
+    attribute.id = record.attr_id;
+    attribute.data.type = (esp_zb_zcl_attr_type_t) record.attr_type;
+    attribute.data.size = record.size;
+    attribute.data.value = record.size > 0 ? (void *) record.value : nullptr;
+    esp_zb_lock_acquire(portMAX_DELAY);
+    esp_err_t err = inject_zb_event(record.event, record.endpoint, record.cluster, attribute);
+    esp_zb_lock_release();
+    this->result_.records++;
+    if (err == ESP_OK) {
+      this->result_.accepted++;
+      hash = trace_hash(hash, record.event, record.endpoint, record.cluster, record.attr_id, record.attr_type,
+                        (const uint8_t *) attribute.data.value, trace_value_size(attribute));
+    } else {
+      this->result_.rejected++;
+    }
+  }
+  if (offset != this->trace_.size()) {
+    ESP_LOGW(TAG, "Trace truncated after %" PRIu32 " records", this->result_.records);
+  }
+  this->result_.expected = hash;
+  this->result_.duration = (esp_timer_get_time() - start) / 1000;
+  this->recorder_->set_paused(false);
+  this->replayed_ = true;
+  this->parent_->enable_loop_soon_any_context();
+}
+
+void ZBTraceReplayer::on_dispatch(const ZBEvent *event) {
+  if (!this->running_) {
+    return;
+  }
+  const esp_zb_zcl_attribute_t *attribute;
+  switch (event->callback_id_) {
+    case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
+      attribute = &event->event_.set_attr.attribute;
+      this->hash_ = trace_hash(this->hash_, INJECT_SET_ATTR, event->event_.set_attr.info.dst_endpoint,
+                               event->event_.set_attr.info.cluster, attribute->id, attribute->data.type,
+                               (const uint8_t *) attribute->data.value, trace_value_size(*attribute));
+      break;
+    case ESP_ZB_CORE_REPORT_ATTR_CB_ID:
+      attribute = &event->event_.report_attr.attribute;
+      this->hash_ = trace_hash(this->hash_, INJECT_REPORT_ATTR, event->event_.report_attr.dst_endpoint,
+                               event->event_.report_attr.cluster, attribute->id, attribute->data.type,
+                               (const uint8_t *) attribute->data.value, trace_value_size(*attribute));
+      break;
+    case ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID:
+      attribute = &event->event_.read_attr_resp.variables.attribute;
+      this->hash_ = trace_hash(this->hash_, INJECT_READ_RESP, event->event_.read_attr_resp.info.dst_endpoint,
+                               event->event_.read_attr_resp.info.cluster, attribute->id, attribute->data.type,
+                               (const uint8_t *) attribute->data.value, trace_value_size(*attribute));
+      break;
+    default:
+      return;
+  }
+  if (this->latencies_.size() < this->latencies_.capacity()) {
+    this->latencies_.push_back(micros() - event->queued_);
+  }
+  this->dispatched_++;
+}
+
+void ZBTraceReplayer::loop() {
+  // wait for the events still in the queue
+  if (!this->running_ || !this->replayed_ || this->dispatched_ + this->dropped_ < this->result_.accepted) {
+    return;
+  }
+  this->log_result_();
+  this->running_ = false;
+  std::vector<uint8_t>().swap(this->trace_);
+  std::vector<uint32_t>().swap(this->latencies_);
+}
+
+void ZBTraceReplayer::log_result_() {
+  std::sort(this->latencies_.begin(), this->latencies_.end());
+  auto percentile = [this](uint8_t p) -> uint32_t {
+    return this->latencies_.empty() ? 0 : this->latencies_[(this->latencies_.size() - 1) * p / 100];
+  };
+  ESP_LOGI(TAG, "Replayed %" PRIu32 " records at %.1fx in %" PRIu32 " ms, %" PRIu32 " rejected", this->result_.records,
+           this->speed_, this->result_.duration, this->result_.rejected);
+  ESP_LOGI(TAG, "  Dispatched %" PRIu32 ", dropped %" PRIu32 ", latency p50 %" PRIu32 " us, p99 %" PRIu32
+           " us, max %" PRIu32 " us", this->dispatched_, this->dropped_, percentile(50), percentile(99),
+           percentile(100));
+  if (this->hash_ == this->result_.expected && this->dropped_ == 0) {
+    ESP_LOGI(TAG, "  Dispatched events match the trace");
+  } else {
+    ESP_LOGW(TAG, "  Dispatched events differ from the trace (hash 0x%08" PRIX32 ", expected 0x%08" PRIX32 ")",
+             this->hash_, this->result_.expected);
+  }
+}
+
+void ZigBeeComponent::dump_trace(bool clear) {
+  if (!this->trace_recorder_.is_enabled()) {
+    ESP_LOGW(TAG, "Event trace is not enabled");
+    return;
+  }
+  if (!this->try_lock()) {
+    ESP_LOGW(TAG, "Zigbee stack busy, trace not dumped");
+    return;
+  }
+  std::vector<uint8_t> trace = this->trace_recorder_.snapshot();
+  uint32_t records = this->trace_recorder_.get_records();
+  uint32_t overwritten = this->trace_recorder_.get_overwritten();
+  if (clear) {
+    this->trace_recorder_.clear();
+  }
+  esp_zb_lock_release();
+
+  static const char *const HEX_CHARS = "0123456789abcdef";
+  char line[TRACE_DUMP_LINE * 2 + 1];
+  ESP_LOGI(TAG, "Trace: %" PRIu32 " records, %zu bytes, %" PRIu32 " overwritten", records, trace.size(),
+           overwritten);
+  for (size_t offset = 0; offset < trace.size(); offset += TRACE_DUMP_LINE) {
+    size_t size = std::min<size_t>(TRACE_DUMP_LINE, trace.size() - offset);
+    for (size_t i = 0; i < size; i++) {
+      line[i * 2] = HEX_CHARS[trace[offset + i] >> 4];
+      line[i * 2 + 1] = HEX_CHARS[trace[offset + i] & 0x0F];
+    }
+    line[size * 2] = '\0';
+    ESP_LOGI(TAG, "trace %04X: %s", (unsigned) offset, line);
+  }
+}
+
+bool ZigBeeComponent::replay_trace(std::vector<uint8_t> trace, float speed) {
+  if (trace.empty() && this->trace_recorder_.is_enabled()) {
+    if (!this->try_lock()) {
+      ESP_LOGW(TAG, "Zigbee stack busy, trace not replayed");
+      return false;
+    }
+    trace = this->trace_recorder_.snapshot();
+    esp_zb_lock_release();
+  }
+  return this->trace_replayer_.start(this, &this->trace_recorder_, std::move(trace), speed);
+}
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ZIGBEE_TRACE
+#include <atomic>
+#include <vector>
+#include "esphome/core/component.h"
+#include "esp_zb_event.h"
+#include "zigbee_inject.h"
+
+namespace esphome {
+namespace zigbee {
+
+// Record header: time (4, us), event (1), endpoint (1), cluster (2), attribute (2), type (1), value size (2), all
+// little endian and followed by the value
+static constexpr uint8_t TRACE_HEADER_SIZE = 13;
+static constexpr uint16_t MAX_TRACE_LATENCIES = 2000;
+static constexpr uint8_t TRACE_DUMP_LINE = 32;  // bytes per log line
+
+struct ZBTraceRecord {
+  uint32_t time;
+  ZBInjectEvent event;
+  uint8_t endpoint;
+  uint16_t cluster;
+  uint16_t attr_id;
+  uint8_t attr_type;
+  uint16_t size;
+  const uint8_t *value;
+};
+
+// Reads the records of a trace, returns false at the end or if the trace is truncated
+bool read_trace_record(const uint8_t *trace, size_t size, size_t &offset, ZBTraceRecord &record);
+// Order dependent fingerprint of the events, the same for the recorded and the dispatched event
+uint32_t trace_hash(uint32_t hash, ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, uint16_t attr_id,
+                    uint8_t attr_type, const uint8_t *value, size_t size);
+
+// Keeps the attribute callbacks passed to zb_action_handler in a RAM ring, the oldest records are overwritten.
+// Records are written in the Zigbee task, snapshot() and clear() need the Zigbee lock.
+class ZBTraceRecorder {
+ public:
+  bool init(size_t size);
+  bool is_enabled() const { return this->ring_ != nullptr; }
+  void set_paused(bool paused) { this->paused_ = paused; }
+  void record(ZBInjectEvent event, uint8_t endpoint, uint16_t cluster, const esp_zb_zcl_attribute_t &attribute);
+  // The records in order, oldest first
+  std::vector<uint8_t> snapshot() const;
+  void clear();
+  uint32_t get_records() const { return this->records_; }
+  uint32_t get_overwritten() const { return this->overwritten_; }
+  size_t get_size() const { return this->size_; }
+
+ protected:
+  void put_(const uint8_t *data, size_t size);
+
+  uint8_t *ring_{nullptr};
+  size_t size_{0};
+  size_t head_{0};  // oldest record
+  size_t used_{0};
+  uint32_t records_{0};
+  uint32_t overwritten_{0};
+  std::atomic<bool> paused_{false};
+};
+
+struct ZBReplayResult {
+  uint32_t records;
+  uint32_t accepted;  // events the handler queued or dropped
+  uint32_t rejected;
+  uint32_t duration;  // ms
+  uint32_t expected;  // trace_hash of the accepted events
+};
+
+// Feeds a trace back into zb_action_handler from a separate task, with the original timing scaled by speed or as
+// fast as possible. The dispatched events are compared with the accepted ones in the main loop.
+class ZBTraceReplayer {
+ public:
+  bool start(Component *parent, ZBTraceRecorder *recorder, std::vector<uint8_t> trace, float speed);
+  bool is_running() const { return this->running_; }
+  // Called in the main loop for every dispatched event, before the event is released
+  void on_dispatch(const ZBEvent *event);
+  void add_dropped(uint16_t dropped) { this->dropped_ += dropped; }
+  // Called in the main loop after the queue was drained, logs the result once all events are dispatched
+  void loop();
+
+ protected:
+  static void task_(void *arg);
+  void run_();
+  void log_result_();
+
+  Component *parent_{nullptr};
+  ZBTraceRecorder *recorder_{nullptr};
+  std::vector<uint8_t> trace_;
+  float speed_{1.0f};
+  ZBReplayResult result_{};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> replayed_{false};  // the task finished, result_ is complete
+  uint32_t dispatched_{0};
+  uint32_t dropped_{0};
+  uint32_t hash_{0};
+  std::vector<uint32_t> latencies_;
+};
+
+}  // namespace zigbee
+}  // namespace esphome
+#endif
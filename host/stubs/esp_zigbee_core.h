@@ -0,0 +1,178 @@
+#pragma once
+
+// Host stand-in for the parts of the esp-zigbee-sdk API used by the host build. Only types and constants, the
+// layouts follow the SDK but are not binary compatible with it.
+
+#include <cstdint>
+
+typedef enum {
+  ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00,
+  ESP_ZB_ZCL_ATTR_TYPE_8BIT = 0x08,
+  ESP_ZB_ZCL_ATTR_TYPE_16BIT = 0x09,
+  ESP_ZB_ZCL_ATTR_TYPE_24BIT = 0x0a,
+  ESP_ZB_ZCL_ATTR_TYPE_32BIT = 0x0b,
+  ESP_ZB_ZCL_ATTR_TYPE_40BIT = 0x0c,
+  ESP_ZB_ZCL_ATTR_TYPE_48BIT = 0x0d,
+  ESP_ZB_ZCL_ATTR_TYPE_56BIT = 0x0e,
+  ESP_ZB_ZCL_ATTR_TYPE_64BIT = 0x0f,
+  ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10,
+  ESP_ZB_ZCL_ATTR_TYPE_8BITMAP = 0x18,
+  ESP_ZB_ZCL_ATTR_TYPE_16BITMAP = 0x19,
+  ESP_ZB_ZCL_ATTR_TYPE_24BITMAP = 0x1a,
+  ESP_ZB_ZCL_ATTR_TYPE_32BITMAP = 0x1b,
+  ESP_ZB_ZCL_ATTR_TYPE_40BITMAP = 0x1c,
+  ESP_ZB_ZCL_ATTR_TYPE_48BITMAP = 0x1d,
+  ESP_ZB_ZCL_ATTR_TYPE_56BITMAP = 0x1e,
+  ESP_ZB_ZCL_ATTR_TYPE_64BITMAP = 0x1f,
+  ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20,
+  ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21,
+  ESP_ZB_ZCL_ATTR_TYPE_U24 = 0x22,
+  ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23,
+  ESP_ZB_ZCL_ATTR_TYPE_U40 = 0x24,
+  ESP_ZB_ZCL_ATTR_TYPE_U48 = 0x25,
+  ESP_ZB_ZCL_ATTR_TYPE_U56 = 0x26,
+  ESP_ZB_ZCL_ATTR_TYPE_U64 = 0x27,
+  ESP_ZB_ZCL_ATTR_TYPE_S8 = 0x28,
+  ESP_ZB_ZCL_ATTR_TYPE_S16 = 0x29,
+  ESP_ZB_ZCL_ATTR_TYPE_S24 = 0x2a,
+  ESP_ZB_ZCL_ATTR_TYPE_S32 = 0x2b,
+  ESP_ZB_ZCL_ATTR_TYPE_S40 = 0x2c,
+  ESP_ZB_ZCL_ATTR_TYPE_S48 = 0x2d,
+  ESP_ZB_ZCL_ATTR_TYPE_S56 = 0x2e,
+  ESP_ZB_ZCL_ATTR_TYPE_S64 = 0x2f,
+  ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30,
+  ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM = 0x31,
+  ESP_ZB_ZCL_ATTR_TYPE_SEMI = 0x38,
+  ESP_ZB_ZCL_ATTR_TYPE_SINGLE = 0x39,
+  ESP_ZB_ZCL_ATTR_TYPE_DOUBLE = 0x3a,
+  ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+  ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42,
+  ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING = 0x43,
+  ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING = 0x44,
+  ESP_ZB_ZCL_ATTR_TYPE_ARRAY = 0x48,
+  ESP_ZB_ZCL_ATTR_TYPE_16BIT_ARRAY = 0x49,
+  ESP_ZB_ZCL_ATTR_TYPE_32BIT_ARRAY = 0x4a,
+  ESP_ZB_ZCL_ATTR_TYPE_STRUCTURE = 0x4c,
+  ESP_ZB_ZCL_ATTR_TYPE_SET = 0x50,
+  ESP_ZB_ZCL_ATTR_TYPE_BAG = 0x51,
+  ESP_ZB_ZCL_ATTR_TYPE_TIME_OF_DAY = 0xe0,
+  ESP_ZB_ZCL_ATTR_TYPE_DATE = 0xe1,
+  ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME = 0xe2,
+  ESP_ZB_ZCL_ATTR_TYPE_CLUSTER_ID = 0xe8,
+  ESP_ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID = 0xe9,
+  ESP_ZB_ZCL_ATTR_TYPE_BACNET_OID = 0xea,
+  ESP_ZB_ZCL_ATTR_TYPE_IEEE_ADDR = 0xf0,
+  ESP_ZB_ZCL_ATTR_TYPE_128_BIT_KEY = 0xf1,
+  ESP_ZB_ZCL_ATTR_TYPE_INVALID = 0xff,
+} esp_zb_zcl_attr_type_t;
+
+typedef enum {
+  ESP_ZB_ZCL_STATUS_SUCCESS = 0x00,
+  ESP_ZB_ZCL_STATUS_FAIL = 0x01,
+  ESP_ZB_ZCL_STATUS_UNSUP_ATTRIB = 0x86,
+  ESP_ZB_ZCL_STATUS_TIMEOUT = 0x94,
+} esp_zb_zcl_status_t;
+
+typedef enum {
+  ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+  ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID = 0x0002,
+  ESP_ZB_CORE_BASIC_RESET_TO_FACTORY_RESET_CB_ID = 0x000b,
+  ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID = 0x1000,
+  ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID = 0x1001,
+  ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID = 0x1005,
+  ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID = 0x1009,
+  ESP_ZB_CORE_REPORT_ATTR_CB_ID = 0x2000,
+} esp_zb_core_action_callback_id_t;
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+
+typedef struct {
+  uint8_t addr_type;
+  union {
+    uint16_t short_addr;
+    uint16_t src_id;
+    esp_zb_ieee_addr_t ieee_addr;
+  } u;
+} esp_zb_zcl_addr_t;
+
+typedef struct {
+  esp_zb_zcl_attr_type_t type;
+  uint16_t size;
+  void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct {
+  uint16_t id;
+  esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+typedef struct {
+  esp_zb_zcl_status_t status;
+  uint8_t dst_endpoint;
+  uint16_t cluster;
+} esp_zb_device_cb_common_info_t;
+
+typedef struct {
+  uint8_t fc;
+  uint16_t manuf_code;
+  uint8_t tsn;
+  int8_t rssi;
+} esp_zb_zcl_frame_header_t;
+
+typedef struct {
+  esp_zb_zcl_status_t status;
+  esp_zb_zcl_frame_header_t header;
+  esp_zb_zcl_addr_t src_address;
+  uint16_t dst_address;
+  uint8_t src_endpoint;
+  uint8_t dst_endpoint;
+  uint16_t cluster;
+  uint16_t profile;
+  uint8_t command_id;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct {
+  esp_zb_zcl_status_t status;
+  esp_zb_zcl_addr_t src_address;
+  uint8_t src_endpoint;
+  uint8_t dst_endpoint;
+  uint16_t cluster;
+  esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_report_attr_message_t;
+
+typedef struct esp_zb_zcl_read_attr_resp_variable_s {
+  esp_zb_zcl_status_t status;
+  esp_zb_zcl_attribute_t attribute;
+  struct esp_zb_zcl_read_attr_resp_variable_s *next;
+} esp_zb_zcl_read_attr_resp_variable_t;
+
+typedef struct {
+  esp_zb_zcl_cmd_info_t info;
+  esp_zb_zcl_read_attr_resp_variable_t *variables;
+} esp_zb_zcl_cmd_read_attr_resp_message_t;
+
+typedef struct esp_zb_zcl_write_attr_resp_variable_s {
+  esp_zb_zcl_status_t status;
+  uint16_t attribute_id;
+  struct esp_zb_zcl_write_attr_resp_variable_s *next;
+} esp_zb_zcl_write_attr_resp_variable_t;
+
+typedef struct {
+  esp_zb_zcl_cmd_info_t info;
+  esp_zb_zcl_write_attr_resp_variable_t *variables;
+} esp_zb_zcl_cmd_write_attr_resp_message_t;
+
+typedef struct {
+  esp_zb_zcl_cmd_info_t info;
+  struct {
+    esp_zb_zcl_attr_type_t type;
+    uint16_t size;
+    void *value;
+  } data;
+} esp_zb_zcl_custom_cluster_command_message_t;
+
+typedef struct {
+  esp_zb_zcl_cmd_info_t info;
+  uint8_t resp_to_cmd;
+  esp_zb_zcl_status_t status_code;
+} esp_zb_zcl_cmd_default_resp_message_t;
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in, the host build uses only esp_zigbee_core.h
@@ -0,0 +1,124 @@
+// Host tests of the ZCL value codec (zigbee_codec.h): half precision floats, the integer types of 24 to 56 bits and
+// the length prefix of strings and arrays.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "zigbee_codec.h"
+
+using namespace esphome::zigbee;
+
+static int failures = 0;  // NOLINT
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static void test_half_float() {
+  CHECK(zcl_half_to_float(0x3C00) == 1.0f);
+  CHECK(zcl_half_to_float(0xC000) == -2.0f);
+  CHECK(zcl_half_to_float(0x7BFF) == 65504.0f);
+  CHECK(zcl_half_to_float(0x0001) == std::ldexp(1.0f, -24));  // smallest subnormal
+  CHECK(std::isinf(zcl_half_to_float(0x7C00)) && zcl_half_to_float(0xFC00) < 0);
+  CHECK(std::isnan(zcl_half_to_float(0x7E00)));
+
+  CHECK(zcl_float_to_half(0.1f) == 0x2E66);
+  CHECK(zcl_float_to_half(65520.0f) == 0x7C00);  // rounds up to infinity
+  CHECK(zcl_float_to_half(1e-9f) == 0x0000);
+  CHECK(zcl_float_to_half(-1e-9f) == 0x8000);
+  CHECK((zcl_float_to_half(NAN) & 0x7C00) == 0x7C00 && (zcl_float_to_half(NAN) & 0x03FF) != 0);
+
+  // every half except NaN survives the round trip through float
+  int mismatches = 0;
+  for (uint32_t half = 0; half <= 0xFFFF; half++) {
+    if ((half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0) {
+      continue;
+    }
+    if (zcl_float_to_half(zcl_half_to_float(half)) != half) {
+      mismatches++;
+    }
+  }
+  CHECK(mismatches == 0);
+
+  uint8_t out[2];
+  zcl_encode_value(ESP_ZB_ZCL_ATTR_TYPE_SEMI, 21.5f, out);
+  CHECK(get_value_by_type<float>(ESP_ZB_ZCL_ATTR_TYPE_SEMI, out) == 21.5f);
+}
+
+static void test_odd_width_integers() {
+  const uint8_t s24[] = {0xFF, 0xFF, 0xFF};
+  CHECK(get_value_by_type<int64_t>(ESP_ZB_ZCL_ATTR_TYPE_S24, s24) == -1);
+  const uint8_t s24_min[] = {0x00, 0x00, 0x80};
+  CHECK(get_value_by_type<int32_t>(ESP_ZB_ZCL_ATTR_TYPE_S24, s24_min) == -8388608);
+  const uint8_t s40[] = {0x00, 0x00, 0x00, 0x00, 0x80};
+  CHECK(get_value_by_type<int64_t>(ESP_ZB_ZCL_ATTR_TYPE_S40, s40) == -(INT64_C(1) << 39));
+  const uint8_t s48[] = {0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  CHECK(get_value_by_type<int64_t>(ESP_ZB_ZCL_ATTR_TYPE_S48, s48) == -2);
+  const uint8_t s56[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F};
+  CHECK(get_value_by_type<int64_t>(ESP_ZB_ZCL_ATTR_TYPE_S56, s56) == (INT64_C(1) << 55) - 1);
+  const uint8_t u48[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA};  // last byte is not part of the value
+  CHECK(get_value_by_type<uint64_t>(ESP_ZB_ZCL_ATTR_TYPE_U48, u48) == UINT64_C(0xFFFFFFFFFFFF));
+
+  // encoding writes exactly the width of the type
+  const uint8_t types[] = {ESP_ZB_ZCL_ATTR_TYPE_S24, ESP_ZB_ZCL_ATTR_TYPE_S40, ESP_ZB_ZCL_ATTR_TYPE_S48,
+                           ESP_ZB_ZCL_ATTR_TYPE_S56};
+  for (uint8_t type : types) {
+    uint8_t out[9];
+    memset(out, 0xAA, sizeof(out));
+    zcl_encode_value(type, (int64_t) -12345, out);
+    uint8_t size = zcl_fixed_size(type);
+    CHECK(out[size] == 0xAA);
+    CHECK(get_value_by_type<int64_t>(type, out) == -12345);
+  }
+}
+
+static void test_length_prefix() {
+  uint8_t *str = get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, "abc", 3, 10);
+  CHECK(str[0] == 3 && memcmp(str + 1, "abc", 3) == 0);
+  CHECK(zcl_value_size(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, str) == 4);
+  CHECK(get_value_by_type<std::string>(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, str) == "abc");
+  delete[] str;
+
+  str = get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, "abc", 3, 10, true);  // capacity of the attribute
+  CHECK(str[0] == 10 && str[4] == 0 && str[10] == 0);
+  delete[] str;
+
+  str = get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, "abc", 3, 300, true);  // short strings end at 254
+  CHECK(str[0] == 254);
+  delete[] str;
+
+  char data[300];
+  memset(data, 'x', sizeof(data));
+  str = get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING, data, sizeof(data), 1000);
+  CHECK(str[0] == (300 & 0xFF) && str[1] == (300 >> 8) && str[2] == 'x' && str[301] == 'x');
+  CHECK(zcl_value_size(ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING, str) == 302);
+  CHECK(zcl_value_size(ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING, str, 100) == 100);
+  delete[] str;
+
+  str = get_zcl_bytes(ESP_ZB_ZCL_ATTR_TYPE_ARRAY, data, 5, 3);  // truncated to the capacity
+  CHECK(str[0] == 3 && str[1] == 0);
+  delete[] str;
+
+  const uint8_t invalid_short[] = {0xFF};
+  const uint8_t invalid_long[] = {0xFF, 0xFF};
+  CHECK(zcl_bytes_view(ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, invalid_short).size == 0);
+  CHECK(zcl_bytes_view(ESP_ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING, invalid_long).size == 0);
+  CHECK(zcl_value_size(ESP_ZB_ZCL_ATTR_TYPE_U48, nullptr) == 6);
+}
+
+int main() {
+  test_half_float();
+  test_odd_width_integers();
+  test_length_prefix();
+  if (failures != 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All codec tests passed\n");
+  return 0;
+}
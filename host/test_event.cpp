@@ -0,0 +1,185 @@
+// Host tests of the event copy path (esp_zb_event.h): values handed over by the Zigbee task must be copied into the
+// event and freed again on release. Build with -DZB_HOST_SANITIZE=ON to catch leaks and out of bounds reads.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "esp_zb_event.h"
+
+using esphome::zigbee::MAX_ZB_CMD_PAYLOAD;
+using esphome::zigbee::ZBEvent;
+
+static int failures = 0;  // NOLINT
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static esp_zb_zcl_attribute_t make_attribute(uint16_t id, esp_zb_zcl_attr_type_t type, void *value) {
+  esp_zb_zcl_attribute_t attribute = {};
+  attribute.id = id;
+  attribute.data.type = type;
+  attribute.data.value = value;
+  return attribute;
+}
+
+static void test_set_attr_inline() {
+  uint16_t value = 0x1234;
+  esp_zb_device_cb_common_info_t info = {ESP_ZB_ZCL_STATUS_SUCCESS, 1, 0x0006};
+  ZBEvent event(info, make_attribute(0, ESP_ZB_ZCL_ATTR_TYPE_U16, &value), nullptr);
+  value = 0;
+  CHECK(event.event_.set_attr.attribute.data.value == event.event_.set_attr.inline_data);
+  CHECK(*(uint16_t *) event.event_.set_attr.attribute.data.value == 0x1234);
+  CHECK(!event.event_.set_attr.has_current_level);
+}
+
+static void test_set_attr_allocated() {
+  uint8_t value[6] = {1, 2, 3, 4, 5, 0x86};  // S48
+  uint8_t level = 42;
+  esp_zb_device_cb_common_info_t info = {ESP_ZB_ZCL_STATUS_SUCCESS, 1, 0x0702};
+  ZBEvent event(info, make_attribute(0, ESP_ZB_ZCL_ATTR_TYPE_S48, value), &level);
+  CHECK(event.event_.set_attr.attribute.data.value != value);
+  CHECK(event.event_.set_attr.attribute.data.value != event.event_.set_attr.inline_data);
+  CHECK(memcmp(event.event_.set_attr.attribute.data.value, value, sizeof(value)) == 0);
+  CHECK(event.event_.set_attr.has_current_level && event.event_.set_attr.current_level == 42);
+}
+
+static void test_report_string() {
+  uint8_t value[] = {5, 'h', 'e', 'l', 'l', 'o'};
+  esp_zb_zcl_report_attr_message_t message = {};
+  message.dst_endpoint = 1;
+  message.cluster = 0x0000;
+  message.attribute = make_attribute(5, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, value);
+  ZBEvent event(&message);
+  memset(value, 0, sizeof(value));
+  const uint8_t *copy = (const uint8_t *) event.event_.report_attr.attribute.data.value;
+  CHECK(copy[0] == 5 && memcmp(copy + 1, "hello", 5) == 0);
+}
+
+static void test_clamped_length() {
+  // the length claims 300 bytes, the stack buffer holds 10: only the buffer is copied and the length shortened
+  uint8_t *value = (uint8_t *) malloc(10);
+  value[0] = 300 & 0xFF;
+  value[1] = 300 >> 8;
+  memcpy(value + 2, "abcdefgh", 8);
+  esp_zb_zcl_report_attr_message_t message = {};
+  message.attribute = make_attribute(0, ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING, value);
+  message.attribute.data.size = 10;
+  ZBEvent event(&message);
+  free(value);
+  const uint8_t *copy = (const uint8_t *) event.event_.report_attr.attribute.data.value;
+  CHECK(copy[0] == 8 && copy[1] == 0 && memcmp(copy + 2, "abcdefgh", 8) == 0);
+
+  // a buffer smaller than the length prefix gives an empty string
+  uint8_t tiny[1] = {5};
+  message.attribute = make_attribute(0, ESP_ZB_ZCL_ATTR_TYPE_LONG_CHAR_STRING, tiny);
+  message.attribute.data.size = 1;
+  event.load_report_attr_event(&message);
+  copy = (const uint8_t *) event.event_.report_attr.attribute.data.value;
+  CHECK(copy[0] == 0 && copy[1] == 0);
+}
+
+static void test_read_resp_list() {
+  uint8_t u8 = 7;
+  uint8_t str[] = {3, 'a', 'b', 'c'};
+  uint32_t u32 = 0xDEADBEEF;
+  esp_zb_zcl_read_attr_resp_variable_t third = {ESP_ZB_ZCL_STATUS_SUCCESS,
+                                                make_attribute(3, ESP_ZB_ZCL_ATTR_TYPE_U32, &u32), nullptr};
+  esp_zb_zcl_read_attr_resp_variable_t second = {ESP_ZB_ZCL_STATUS_SUCCESS,
+                                                 make_attribute(2, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, str), &third};
+  esp_zb_zcl_read_attr_resp_variable_t first = {ESP_ZB_ZCL_STATUS_SUCCESS,
+                                                make_attribute(1, ESP_ZB_ZCL_ATTR_TYPE_U8, &u8), &second};
+  esp_zb_zcl_cmd_info_t info = {};
+  info.status = ESP_ZB_ZCL_STATUS_SUCCESS;
+  info.cluster = 0x0402;
+
+  ZBEvent event;
+  event.load_read_attr_resp_event(info, &first);
+  const esp_zb_zcl_read_attr_resp_variable_t *var = &event.event_.read_attr_resp.variables;
+  CHECK(var->attribute.id == 1 && *(uint8_t *) var->attribute.data.value == 7);
+  var = var->next;
+  CHECK(var != nullptr && var != &second);
+  CHECK(var->attribute.id == 2 && memcmp(var->attribute.data.value, str, sizeof(str)) == 0);
+  var = var->next;
+  CHECK(var != nullptr && var->attribute.id == 3 && *(uint32_t *) var->attribute.data.value == 0xDEADBEEF);
+  CHECK(var->next == nullptr);
+
+  // a failed response reuses the pooled event without variables, nothing of the old list may remain
+  info.status = ESP_ZB_ZCL_STATUS_FAIL;
+  event.load_read_attr_resp_event(info, nullptr);
+  CHECK(event.event_.read_attr_resp.info.status == ESP_ZB_ZCL_STATUS_FAIL);
+  CHECK(event.event_.read_attr_resp.variables.next == nullptr);
+  CHECK(event.event_.read_attr_resp.variables.attribute.data.value == nullptr);
+
+  event.load_read_attr_resp_event(info, &first);
+  event.release();
+  CHECK(event.event_.read_attr_resp.variables.next == nullptr);
+}
+
+static void test_reload_other_type() {
+  uint8_t value[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  esp_zb_device_cb_common_info_t info = {ESP_ZB_ZCL_STATUS_SUCCESS, 1, 0x0000};
+  ZBEvent event;
+  event.load_set_attr_value_event(info, make_attribute(0, ESP_ZB_ZCL_ATTR_TYPE_U64, value), nullptr);
+  esp_zb_zcl_cmd_default_resp_message_t message = {};
+  message.resp_to_cmd = 0x0B;
+  message.status_code = ESP_ZB_ZCL_STATUS_FAIL;
+  event.load_default_resp_event(&message);
+  CHECK(event.callback_id_ == ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID);
+  CHECK(event.event_.default_resp.resp_to_cmd == 0x0B);
+}
+
+static void test_custom_cmd_payload() {
+  uint8_t payload[MAX_ZB_CMD_PAYLOAD];
+  for (uint8_t i = 0; i < sizeof(payload); i++) {
+    payload[i] = i;
+  }
+  esp_zb_zcl_custom_cluster_command_message_t message = {};
+  message.info.cluster = 0xFC00;
+  message.data.size = 2;
+  message.data.value = payload;
+  ZBEvent event(&message);
+  CHECK(event.event_.custom_cmd.data == event.event_.custom_cmd.inline_data);
+  CHECK(event.event_.custom_cmd.size == 2 && event.event_.custom_cmd.data[1] == 1);
+
+  // a long payload is allocated and freed on reload
+  message.data.size = sizeof(payload);
+  event.load_custom_cmd_event(&message);
+  memset(payload, 0, sizeof(payload));
+  CHECK(event.event_.custom_cmd.data != event.event_.custom_cmd.inline_data);
+  CHECK(event.event_.custom_cmd.size == MAX_ZB_CMD_PAYLOAD && event.event_.custom_cmd.data[63] == 63);
+
+  message.data.size = 0;
+  message.data.value = nullptr;
+  event.load_custom_cmd_event(&message);
+  CHECK(event.event_.custom_cmd.size == 0 && event.event_.custom_cmd.data != nullptr);
+}
+
+static void test_scene_recall() {
+  uint8_t scene[20] = {0x06, 0x00, 0x00, 0x00, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 1};
+  ZBEvent event(1, scene, sizeof(scene));
+  memset(scene, 0, sizeof(scene));
+  CHECK(event.event_.scene_recall.data != event.event_.scene_recall.inline_data);
+  CHECK(event.event_.scene_recall.size == 20 && event.event_.scene_recall.data[5] == 1);
+}
+
+int main() {
+  test_set_attr_inline();
+  test_set_attr_allocated();
+  test_report_string();
+  test_clamped_length();
+  test_read_resp_list();
+  test_reload_other_type();
+  test_custom_cmd_payload();
+  test_scene_recall();
+  if (failures != 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All event tests passed\n");
+  return 0;
+}